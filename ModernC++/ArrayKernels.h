@@ -0,0 +1,248 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// The SIMD paths are picked at compile time. GCC and Clang define __SSE4_1__
+// and __AVX2__ from -m flags. MSVC has no SSE4.1 macro and defines __AVX__ or
+// __AVX2__ only under /arch:AVX or /arch:AVX2; both imply SSE4.1.
+#if defined(__AVX2__)
+#define ARRAY_KERNELS_AVX2 1
+#endif
+#if defined(__AVX2__) || defined(__AVX__) || defined(__SSE4_1__)
+#define ARRAY_KERNELS_SSE41 1
+#include <immintrin.h>
+#endif
+
+/*
+Fixed-size array kernels
+Transforms over std::array<T, N> whose loops are unrolled at compile time by N. Because N is part of the type, the kernels pick a SIMD width that fits N (8 ints for AVX2, 4 for SSE4.1) and finish the tail with unrolled scalar code, and small arrays are sorted with a sorting network instead of std::sort. The width is fixed when the header is compiled, not detected at run time. The Visual Studio project builds for the x64 baseline, where MSVC enables neither path, so it runs the scalar code unless /arch:AVX or /arch:AVX2 is set. Kernels::sum and Kernels::sort in KernelDispatch.h pick their instruction set from CPUID instead.
+
+The batch_* functions apply a kernel to an array-of-arrays, splitting the batch across hardware threads.
+*/
+namespace array_kernels
+{
+	template <typename Fn, std::size_t... I>
+	constexpr void unroll_impl(Fn& fn, std::index_sequence<I...>)
+	{
+		(fn(std::integral_constant<std::size_t, I>{}), ...);
+	}
+
+	// Calls fn(std::integral_constant<std::size_t, I>{}) for I = 0..N-1, fully unrolled.
+	template <std::size_t N, typename Fn>
+	constexpr void unroll(Fn&& fn)
+	{
+		unroll_impl(fn, std::make_index_sequence<N>{});
+	}
+
+	// a[i] = fn(a[i]) for every element, unrolled.
+	template <typename T, std::size_t N, typename Fn>
+	constexpr void transform(std::array<T, N>& a, Fn fn)
+	{
+		unroll<N>([&](auto i) { a[i] = fn(a[i]); });
+	}
+
+	namespace detail
+	{
+		// Number of lanes used for an int kernel over N elements: the widest
+		// available vector that still fits into N, or 1 for the scalar path.
+		template <std::size_t N>
+		constexpr std::size_t int_lanes()
+		{
+#if defined(ARRAY_KERNELS_AVX2)
+			if (N >= 8) return 8;
+#endif
+#if defined(ARRAY_KERNELS_SSE41)
+			if (N >= 4) return 4;
+#endif
+			return 1;
+		}
+
+		template <std::size_t Lanes>
+		inline void scale_block(int* p, int k)
+		{
+#if defined(ARRAY_KERNELS_AVX2)
+			if constexpr (Lanes == 8)
+			{
+				__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_mullo_epi32(v, _mm256_set1_epi32(k)));
+				return;
+			}
+#endif
+#if defined(ARRAY_KERNELS_SSE41)
+			if constexpr (Lanes == 4)
+			{
+				__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_mullo_epi32(v, _mm_set1_epi32(k)));
+				return;
+			}
+#endif
+			for (std::size_t i = 0; i < Lanes; ++i)
+			{
+				p[i] *= k;
+			}
+		}
+
+		// Batcher's odd-even merge sort network for the next power of two >= N,
+		// keeping only comparators whose indices are both below N. Dropping the
+		// others is equivalent to padding the input with +infinity.
+		constexpr std::size_t ceil_pow2(std::size_t n)
+		{
+			std::size_t p = 1;
+			while (p < n) p *= 2;
+			return p;
+		}
+
+		template <typename Emit>
+		constexpr void batcher(std::size_t n, Emit&& emit)
+		{
+			const std::size_t m = ceil_pow2(n);
+			for (std::size_t p = 1; p < m; p += p)
+			{
+				for (std::size_t k = p; k >= 1; k /= 2)
+				{
+					for (std::size_t j = k % p; j + k < m; j += 2 * k)
+					{
+						for (std::size_t i = 0; i < k && i + j + k < m; ++i)
+						{
+							const std::size_t a = i + j, b = i + j + k;
+							if (a / (2 * p) == b / (2 * p) && b < n)
+							{
+								emit(a, b);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		struct comparator
+		{
+			std::size_t lo;
+			std::size_t hi;
+		};
+
+		constexpr std::size_t network_size(std::size_t n)
+		{
+			std::size_t count = 0;
+			batcher(n, [&](std::size_t, std::size_t) { ++count; });
+			return count;
+		}
+
+		template <std::size_t N>
+		constexpr auto make_network()
+		{
+			std::array<comparator, network_size(N)> net{};
+			std::size_t c = 0;
+			batcher(N, [&](std::size_t a, std::size_t b) {
+				net[c].lo = a;
+				net[c++].hi = b;
+			});
+			return net;
+		}
+
+		template <std::size_t N>
+		constexpr auto network = make_network<N>();
+
+		template <typename T>
+		constexpr void compare_exchange(T& a, T& b)
+		{
+			const T lo = b < a ? b : a;
+			const T hi = b < a ? a : b;
+			a = lo;
+			b = hi;
+		}
+	}
+
+	// Largest N that is sorted with a network; bigger arrays use std::sort.
+	constexpr std::size_t max_network_size = 32;
+
+	// a[i] *= k for every element, using SIMD blocks matched to N for int.
+	template <typename T, std::size_t N>
+	inline void scale(std::array<T, N>& a, T k)
+	{
+		if constexpr (std::is_same<T, int>::value && detail::int_lanes<N>() > 1)
+		{
+			constexpr std::size_t lanes = detail::int_lanes<N>();
+			constexpr std::size_t blocks = N / lanes;
+			unroll<blocks>([&](auto b) { detail::scale_block<lanes>(a.data() + b * lanes, k); });
+			unroll<N - blocks * lanes>([&](auto i) { a[blocks * lanes + i] *= k; });
+		}
+		else
+		{
+			unroll<N>([&](auto i) { a[i] *= k; });
+		}
+	}
+
+	// Sorts ascending. Sorting networks are branch-free and fully unrolled.
+	template <typename T, std::size_t N>
+	constexpr void sort(std::array<T, N>& a)
+	{
+		if constexpr (N <= max_network_size)
+		{
+			constexpr auto& net = detail::network<N>;
+			unroll<net.size()>([&](auto c) {
+				detail::compare_exchange(a[net[c].lo], a[net[c].hi]);
+			});
+		}
+		else
+		{
+			std::sort(a.begin(), a.end());
+		}
+	}
+
+	// Runs fn(first, last) over contiguous slices of [0, count) on all hardware threads.
+	template <typename Fn>
+	void parallel_chunks(std::size_t count, Fn fn, std::size_t min_chunk = 4096)
+	{
+		const std::size_t hw = std::max<std::size_t>(1, std::thread::hardware_concurrency());
+		const std::size_t workers = std::min(hw, std::max<std::size_t>(1, count / min_chunk));
+		if (workers <= 1)
+		{
+			fn(std::size_t(0), count);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		threads.reserve(workers - 1);
+		const std::size_t step = (count + workers - 1) / workers;
+		for (std::size_t w = 1; w < workers; ++w)
+		{
+			const std::size_t first = std::min(count, w * step);
+			const std::size_t last = std::min(count, first + step);
+			threads.emplace_back([=, &fn] { fn(first, last); });
+		}
+		fn(std::size_t(0), std::min(count, step));
+		for (auto& t : threads)
+		{
+			t.join();
+		}
+	}
+
+	template <typename T, std::size_t N, typename Kernel>
+	void batch_apply(std::vector<std::array<T, N>>& batch, Kernel kernel)
+	{
+		parallel_chunks(batch.size(), [&](std::size_t first, std::size_t last) {
+			for (std::size_t i = first; i < last; ++i)
+			{
+				kernel(batch[i]);
+			}
+		});
+	}
+
+	template <typename T, std::size_t N>
+	void batch_scale(std::vector<std::array<T, N>>& batch, T k)
+	{
+		batch_apply(batch, [k](std::array<T, N>& a) { scale(a, k); });
+	}
+
+	template <typename T, std::size_t N>
+	void batch_sort(std::vector<std::array<T, N>>& batch)
+	{
+		batch_apply(batch, [](std::array<T, N>& a) { sort(a); });
+	}
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ArrayKernels.h"
+
+/*
+Batch invocation
+std::apply(add, std::make_tuple(1, 2)) calls add once with one tuple of arguments. Applying the same small function to millions of argument tuples that way builds and unpacks a tuple per call, and the calls cannot be vectorized. batch::apply(fn, args, out) takes the arguments as columns instead: args is a tuple of batch::column spans, one per parameter, all of the same length (a structure of arrays). It computes out[i] = fn(a[i], b[i], ...) for every row. The tuple is unpacked once, with an index_sequence, into one plain pointer per column, so the loop is a single pass over arrays. The compiler inlines fn and can vectorize the loop, as it does for vexpr.
+
+for_each_row(fn, args) calls fn(a[i], b[i], ...) without collecting results. fn receives references into the columns, so it can also write them. parallel_apply() and parallel_for_each_row() split the rows with array_kernels::parallel_chunks. Each thread runs the same loop over its own slice.
+
+A column is a non-owning view, so it must not outlive its storage. out may be one of the argument columns; other overlaps between out and the arguments are not allowed.
+*/
+namespace batch
+{
+	// Non-owning view of n contiguous T.
+	template <typename T>
+	struct column
+	{
+		T* data = nullptr;
+		std::size_t n = 0;
+
+		column() = default;
+		column(T* p, std::size_t n) : data(p), n(n) {}
+		template <typename U, typename A, typename = std::enable_if_t<std::is_same<std::remove_const_t<T>, U>::value>>
+		column(std::vector<U, A>& v) : data(v.data()), n(v.size()) {}
+		template <typename U, typename A, typename = std::enable_if_t<std::is_same<T, const U>::value>>
+		column(const std::vector<U, A>& v) : data(v.data()), n(v.size()) {}
+
+		std::size_t size() const { return n; }
+		T& operator[](std::size_t i) const { return data[i]; }
+		T* begin() const { return data; }
+		T* end() const { return data + n; }
+	};
+
+	template <typename T, typename A>
+	column(std::vector<T, A>&) -> column<T>;
+	template <typename T, typename A>
+	column(const std::vector<T, A>&) -> column<const T>;
+
+	// columns(a, b, c): a tuple of column views over vectors or columns.
+	template <typename... Cs>
+	auto columns(Cs&&... cs) { return std::make_tuple(column(std::forward<Cs>(cs))...); }
+
+	namespace detail
+	{
+		template <typename Args, std::size_t... I>
+		std::size_t rows(const Args& args, std::index_sequence<I...>)
+		{
+			const std::size_t n = std::get<0>(args).size();
+			assert(((std::get<I>(args).size() == n) && ...) && "batch: columns differ in length");
+			return n;
+		}
+
+		template <typename... Ts>
+		std::size_t rows(const std::tuple<column<Ts>...>& args)
+		{
+			static_assert(sizeof...(Ts) > 0, "batch: no argument columns");
+			return rows(args, std::index_sequence_for<Ts...>());
+		}
+
+		// The loops take the column pointers as separate parameters, so each is
+		// a local the compiler keeps in a register for the whole range.
+		template <typename Fn, typename R, typename... Ts>
+		void apply_range(Fn& fn, R* out, std::size_t first, std::size_t last, Ts*... in)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				out[i] = fn(in[i]...);
+			}
+		}
+
+		// Same, for an out that overlaps no argument. Without __restrict the
+		// compiler must either prove that or check it at run time before it
+		// vectorizes, and at the cheaper optimization levels it does neither.
+		template <typename Fn, typename R, typename... Ts>
+		void apply_range_disjoint(Fn& fn, R* __restrict out, std::size_t first, std::size_t last, Ts* __restrict... in)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				out[i] = fn(in[i]...);
+			}
+		}
+
+		template <typename Fn, typename... Ts>
+		void for_each_range(Fn& fn, std::size_t first, std::size_t last, Ts*... in)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				fn(in[i]...);
+			}
+		}
+
+		template <typename Fn, typename R, typename Args, std::size_t... I>
+		void apply(Fn& fn, const Args& args, R* out, std::size_t first, std::size_t last, std::index_sequence<I...>)
+		{
+			if (((static_cast<const void*>(std::get<I>(args).data) == static_cast<const void*>(out)) || ...))
+			{
+				apply_range(fn, out, first, last, std::get<I>(args).data...);
+			}
+			else
+			{
+				apply_range_disjoint(fn, out, first, last, std::get<I>(args).data...);
+			}
+		}
+
+		template <typename Fn, typename Args, std::size_t... I>
+		void for_each(Fn& fn, const Args& args, std::size_t first, std::size_t last, std::index_sequence<I...>)
+		{
+			for_each_range(fn, first, last, std::get<I>(args).data...);
+		}
+	}
+
+	// out[i] = fn(args[i]...) for every row. out must have as many rows as the arguments.
+	template <typename Fn, typename... Ts, typename R>
+	void apply(Fn&& fn, const std::tuple<column<Ts>...>& args, column<R> out)
+	{
+		const std::size_t n = detail::rows(args);
+		assert(out.size() == n);
+		detail::apply(fn, args, out.data, 0, n, std::index_sequence_for<Ts...>());
+	}
+
+	template <typename Fn, typename... Ts>
+	void for_each_row(Fn&& fn, const std::tuple<column<Ts>...>& args)
+	{
+		detail::for_each(fn, args, 0, detail::rows(args), std::index_sequence_for<Ts...>());
+	}
+
+	// apply() with the rows split across hardware threads; fn is called concurrently.
+	template <typename Fn, typename... Ts, typename R>
+	void parallel_apply(Fn&& fn, const std::tuple<column<Ts>...>& args, column<R> out, std::size_t min_chunk = 1 << 16)
+	{
+		const std::size_t n = detail::rows(args);
+		assert(out.size() == n);
+		array_kernels::parallel_chunks(n, [&](std::size_t first, std::size_t last) {
+			detail::apply(fn, args, out.data, first, last, std::index_sequence_for<Ts...>());
+		}, min_chunk);
+	}
+
+	template <typename Fn, typename... Ts>
+	void parallel_for_each_row(Fn&& fn, const std::tuple<column<Ts>...>& args, std::size_t min_chunk = 1 << 16)
+	{
+		array_kernels::parallel_chunks(detail::rows(args), [&](std::size_t first, std::size_t last) {
+			detail::for_each(fn, args, first, last, std::index_sequence_for<Ts...>());
+		}, min_chunk);
+	}
+}
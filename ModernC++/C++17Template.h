@@ -192,9 +192,18 @@ struct C : B2
 	// virtual void foo(); // error -- declaration of 'foo' overrides a 'final' function
 };
 
+// Defined so that the examples link. Dispatch.h measures what virtual, final and
+// std::variant dispatch cost.
+inline void A1::foo() {}
+inline void A1::bar() {}
+inline void B1::foo() {}
+inline void A2::foo() {}
+inline void B2::foo() {}
+
 /*
 Deleted functions
 A more elegant, efficient way to provide a deleted implementation of a function. Useful for preventing copies on objects.
+Handles.h applies this to move-only owners of file descriptors, mappings and buffers.
 */
 class A3 
 {
@@ -411,6 +420,8 @@ unordered_set
 unordered_multiset
 unordered_map
 unordered_multimap
+
+For int and string keys, flathash::flat_hash_map/flat_hash_set (FlatHash.h) keep the slots in one flat array and probe 16 of them per SIMD compare instead of chasing a node per bucket.
 */
 
 /*
@@ -431,6 +442,8 @@ See the section on smart pointers for more information on std::unique_ptr and st
 /*
 Memory model
 C++11 introduces a memory model for C++, which means library support for threading and atomic operations. Some of these operations include (but aren't limited to) atomic loads/stores, compare-and-swap, atomic flags, promises, futures, locks, and condition variables.
+
+Queues.h builds its lock-free SPSC/MPMC queues on exactly these acquire/release loads, stores and compare-and-swap loops.
 */
 
 
@@ -526,6 +539,7 @@ decltype(auto) a2t(const std::array<T, N>& a)
 Template argument deduction for class templates
 
 Automatic template argument deduction much like how it's done for functions, but now including class constructors.
+FixedContainers.h adds deduction guides that deduce a capacity as well as a type: fixed::ring_buffer r{ 1, 2, 3 } is a ring_buffer<int, 3>.
 */
 template <typename T = float>
 struct MyContainer
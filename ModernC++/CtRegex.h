@@ -0,0 +1,967 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+Compile-time regular expressions
+std::regex parses its pattern into a state machine at run time, every time a regex object is constructed, and then interprets that machine for every character it matches. When the pattern is a string literal, all of that work can be done by the compiler. CTREGEX("([a-z]+)\\.txt") parses the literal during compilation, and match() and search() are instantiated separately for each state of the parsed program, so the compiler sees tests such as c >= 'a' && c <= 'z' with constant operands. Captures come back as std::string_view into the searched text.
+
+A malformed pattern is a compile error, and the failing static_assert names the problem and its offset. The grammar is a strict subset of ECMAScript: literals, ., [...] and [^...] with ranges, \d \w \s \D \W \S, ( ), (?: ), |, ^, $, and the quantifiers * + ? {m} {m,} {m,n}, each optionally lazy (*?). Back-references and lookaround are not supported. An unescaped space is also rejected, because in a pattern it is almost always a typo: write "\\ " or "[ ]" when a space is meant. A quantified group that can match the empty string, such as (a*)*, is rejected too.
+
+Matching backtracks; a single-character term repeated with * or + is consumed in a loop rather than by recursion.
+*/
+namespace ctregex
+{
+	enum class error : std::uint8_t
+	{
+		none,
+		unescaped_space,
+		unbalanced_paren,
+		unterminated_class,
+		bad_range,
+		bad_escape,
+		nothing_to_repeat,
+		bad_quantifier,
+		empty_loop,
+		too_complex,
+	};
+
+	namespace detail
+	{
+		constexpr std::size_t npos = static_cast<std::size_t>(-1);
+		constexpr std::size_t max_count = 1000; // largest m or n in {m,n}
+
+		// 256-bit character set.
+		struct charset
+		{
+			std::uint64_t bits[4] = {};
+
+			constexpr void add(unsigned char c) { bits[c >> 6] |= std::uint64_t(1) << (c & 63); }
+			constexpr void add_range(unsigned char lo, unsigned char hi)
+			{
+				for (unsigned c = lo; c <= hi; ++c)
+				{
+					add(static_cast<unsigned char>(c));
+				}
+			}
+			constexpr void merge(const charset& o)
+			{
+				for (int i = 0; i < 4; ++i) bits[i] |= o.bits[i];
+			}
+			constexpr void invert()
+			{
+				for (int i = 0; i < 4; ++i) bits[i] = ~bits[i];
+			}
+			constexpr bool test(unsigned char c) const { return (bits[c >> 6] >> (c & 63) & 1) != 0; }
+			constexpr bool disjoint(const charset& o) const
+			{
+				return ((bits[0] & o.bits[0]) | (bits[1] & o.bits[1]) | (bits[2] & o.bits[2]) | (bits[3] & o.bits[3])) == 0;
+			}
+		};
+
+		constexpr charset single(unsigned char c)
+		{
+			charset s;
+			s.add(c);
+			return s;
+		}
+
+		// ECMAScript's . excludes both line terminators, not only '\n'.
+		constexpr charset any_but_newline()
+		{
+			charset s = single('\n');
+			s.add('\r');
+			s.invert();
+			return s;
+		}
+
+		// Parse tree. Children are indices into the same array.
+		enum class ast_kind : std::uint8_t { empty, literal, any, set, bol, eol, concat, alt, group, repeat };
+
+		struct ast_node
+		{
+			ast_kind kind = ast_kind::empty;
+			char ch = 0;
+			bool greedy = true;
+			charset set;
+			std::size_t a = npos;
+			std::size_t b = npos;
+			std::size_t group = npos; // capture index, npos for (?: )
+			std::size_t min = 0;
+			std::size_t max = 0; // npos = unbounded
+		};
+
+		template <std::size_t N>
+		struct tree
+		{
+			ast_node nodes[N] = {};
+			std::size_t count = 0;
+			std::size_t root = npos;
+			std::size_t groups = 0;
+			error err = error::none;
+			std::size_t err_pos = 0;
+		};
+
+		constexpr std::size_t length(const char* s)
+		{
+			std::size_t n = 0;
+			while (s[n] != '\0')
+			{
+				++n;
+			}
+			return n;
+		}
+
+		// Every pattern character adds at most two nodes.
+		constexpr std::size_t tree_capacity(std::size_t len) { return 2 * len + 2; }
+
+		template <std::size_t N>
+		class parser
+		{
+			const char* s;
+			std::size_t pos = 0;
+
+		public:
+			tree<N> t;
+
+			constexpr explicit parser(const char* s) : s(s) {}
+
+			constexpr void run()
+			{
+				t.root = alternation();
+				if (t.err == error::none && s[pos] != '\0')
+				{
+					fail(error::unbalanced_paren); // a ')' with no '('
+				}
+			}
+
+		private:
+			constexpr std::size_t fail(error e)
+			{
+				if (t.err == error::none)
+				{
+					t.err = e;
+					t.err_pos = pos;
+				}
+				return npos;
+			}
+
+			constexpr std::size_t add(const ast_node& n)
+			{
+				if (t.count == N)
+				{
+					return fail(error::too_complex);
+				}
+				t.nodes[t.count] = n;
+				return t.count++;
+			}
+
+			constexpr std::size_t add(ast_kind kind, std::size_t a = npos, std::size_t b = npos)
+			{
+				ast_node n;
+				n.kind = kind;
+				n.a = a;
+				n.b = b;
+				return add(n);
+			}
+
+			constexpr std::size_t alternation()
+			{
+				std::size_t left = concatenation();
+				while (t.err == error::none && s[pos] == '|')
+				{
+					++pos;
+					const std::size_t right = concatenation();
+					left = add(ast_kind::alt, left, right);
+				}
+				return left;
+			}
+
+			constexpr std::size_t concatenation()
+			{
+				std::size_t left = npos;
+				while (t.err == error::none && s[pos] != '\0' && s[pos] != '|' && s[pos] != ')')
+				{
+					const std::size_t right = repetition();
+					left = left == npos ? right : add(ast_kind::concat, left, right);
+				}
+				return left == npos ? add(ast_kind::empty) : left;
+			}
+
+			static constexpr bool is_quantifier(char c) { return c == '*' || c == '+' || c == '?' || c == '{'; }
+
+			constexpr std::size_t repetition()
+			{
+				const std::size_t atom_index = atom();
+				if (t.err != error::none || !is_quantifier(s[pos]))
+				{
+					return atom_index;
+				}
+				const ast_node& body = t.nodes[atom_index];
+				if (body.kind == ast_kind::bol || body.kind == ast_kind::eol)
+				{
+					return fail(error::nothing_to_repeat);
+				}
+
+				ast_node n;
+				n.kind = ast_kind::repeat;
+				n.a = atom_index;
+				switch (s[pos++])
+				{
+				case '*': n.min = 0; n.max = npos; break;
+				case '+': n.min = 1; n.max = npos; break;
+				case '?': n.min = 0; n.max = 1; break;
+				default:
+					if (!counts(n.min, n.max))
+					{
+						return npos;
+					}
+				}
+				if (s[pos] == '?')
+				{
+					n.greedy = false;
+					++pos;
+				}
+				if (is_quantifier(s[pos]))
+				{
+					return fail(error::nothing_to_repeat);
+				}
+				if (n.max == npos && nullable(atom_index))
+				{
+					return fail(error::empty_loop);
+				}
+				return add(n);
+			}
+
+			// The part of {m}, {m,} or {m,n} after the '{'.
+			constexpr bool counts(std::size_t& min, std::size_t& max)
+			{
+				if (!number(min))
+				{
+					return false;
+				}
+				max = min;
+				if (s[pos] == ',')
+				{
+					++pos;
+					max = s[pos] == '}' ? npos : 0;
+					if (max != npos && !number(max))
+					{
+						return false;
+					}
+				}
+				if (s[pos] != '}' || (max != npos && max < min))
+				{
+					fail(error::bad_quantifier);
+					return false;
+				}
+				++pos;
+				return true;
+			}
+
+			constexpr bool number(std::size_t& out)
+			{
+				if (s[pos] < '0' || s[pos] > '9')
+				{
+					fail(error::bad_quantifier);
+					return false;
+				}
+				out = 0;
+				for (; s[pos] >= '0' && s[pos] <= '9'; ++pos)
+				{
+					out = out * 10 + std::size_t(s[pos] - '0');
+					if (out > max_count)
+					{
+						fail(error::bad_quantifier);
+						return false;
+					}
+				}
+				return true;
+			}
+
+			constexpr bool nullable(std::size_t i) const
+			{
+				const ast_node& n = t.nodes[i];
+				switch (n.kind)
+				{
+				case ast_kind::empty:
+				case ast_kind::bol:
+				case ast_kind::eol:
+					return true;
+				case ast_kind::concat:
+					return nullable(n.a) && nullable(n.b);
+				case ast_kind::alt:
+					return nullable(n.a) || nullable(n.b);
+				case ast_kind::group:
+					return nullable(n.a);
+				case ast_kind::repeat:
+					return n.min == 0 || nullable(n.a);
+				default:
+					return false;
+				}
+			}
+
+			constexpr std::size_t atom()
+			{
+				const char c = s[pos];
+				switch (c)
+				{
+				case '(':
+					return group();
+				case '[':
+					++pos;
+					return bracket();
+				case '.':
+					++pos;
+					return add(ast_kind::any);
+				case '^':
+					++pos;
+					return add(ast_kind::bol);
+				case '$':
+					++pos;
+					return add(ast_kind::eol);
+				case '\\':
+				{
+					++pos;
+					ast_node n;
+					if (!escape(n))
+					{
+						return npos;
+					}
+					return add(n);
+				}
+				case ' ':
+					return fail(error::unescaped_space);
+				case '*':
+				case '+':
+				case '?':
+				case '{':
+					return fail(error::nothing_to_repeat);
+				default:
+				{
+					++pos;
+					ast_node n;
+					n.kind = ast_kind::literal;
+					n.ch = c;
+					return add(n);
+				}
+				}
+			}
+
+			constexpr std::size_t group()
+			{
+				++pos;
+				std::size_t index = npos;
+				if (s[pos] == '?')
+				{
+					if (s[pos + 1] != ':')
+					{
+						return fail(error::bad_escape); // lookaround and named groups
+					}
+					pos += 2;
+				}
+				else
+				{
+					index = ++t.groups;
+				}
+				const std::size_t body = alternation();
+				if (t.err != error::none)
+				{
+					return npos;
+				}
+				if (s[pos] != ')')
+				{
+					return fail(error::unbalanced_paren);
+				}
+				++pos;
+				ast_node n;
+				n.kind = ast_kind::group;
+				n.a = body;
+				n.group = index;
+				return add(n);
+			}
+
+			// Escape after a '\'. Produces a literal or a class.
+			constexpr bool escape(ast_node& n)
+			{
+				const char c = s[pos];
+				if (c == '\0')
+				{
+					fail(error::bad_escape);
+					return false;
+				}
+				++pos;
+				n.kind = ast_kind::set;
+				switch (c)
+				{
+				case 'd': n.set.add_range('0', '9'); return true;
+				case 'D': n.set.add_range('0', '9'); n.set.invert(); return true;
+				case 'w': word(n.set); return true;
+				case 'W': word(n.set); n.set.invert(); return true;
+				case 's': space(n.set); return true;
+				case 'S': space(n.set); n.set.invert(); return true;
+				default:
+					break;
+				}
+				n.kind = ast_kind::literal;
+				switch (c)
+				{
+				case 'n': n.ch = '\n'; return true;
+				case 'r': n.ch = '\r'; return true;
+				case 't': n.ch = '\t'; return true;
+				case 'f': n.ch = '\f'; return true;
+				case 'v': n.ch = '\v'; return true;
+				default:
+					break;
+				}
+				if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
+				{
+					--pos;
+					fail(error::bad_escape); // back-references and unknown classes
+					return false;
+				}
+				n.ch = c; // escaped punctuation stands for itself
+				return true;
+			}
+
+			static constexpr void word(charset& set)
+			{
+				set.add_range('a', 'z');
+				set.add_range('A', 'Z');
+				set.add_range('0', '9');
+				set.add('_');
+			}
+
+			static constexpr void space(charset& set)
+			{
+				for (char c : { ' ', '\t', '\n', '\r', '\f', '\v' })
+				{
+					set.add(static_cast<unsigned char>(c));
+				}
+			}
+
+			// The part of [...] after the '['. A ']' right after "[" or "[^" is a literal.
+			constexpr std::size_t bracket()
+			{
+				const std::size_t start = pos - 1;
+				ast_node n;
+				n.kind = ast_kind::set;
+				const bool negate = s[pos] == '^';
+				if (negate)
+				{
+					++pos;
+				}
+				bool first = true;
+				while (s[pos] != ']' || first)
+				{
+					if (s[pos] == '\0')
+					{
+						pos = start;
+						return fail(error::unterminated_class);
+					}
+					first = false;
+					ast_node item;
+					if (!class_item(item))
+					{
+						return npos;
+					}
+					if (item.kind == ast_kind::set)
+					{
+						n.set.merge(item.set);
+						continue;
+					}
+					const unsigned char lo = static_cast<unsigned char>(item.ch);
+					if (s[pos] == '-' && s[pos + 1] != ']' && s[pos + 1] != '\0')
+					{
+						++pos;
+						ast_node upper;
+						if (!class_item(upper))
+						{
+							return npos;
+						}
+						const unsigned char hi = static_cast<unsigned char>(upper.ch);
+						if (upper.kind == ast_kind::set || hi < lo)
+						{
+							return fail(error::bad_range);
+						}
+						n.set.add_range(lo, hi);
+					}
+					else
+					{
+						n.set.add(lo);
+					}
+				}
+				++pos;
+				if (negate)
+				{
+					n.set.invert();
+				}
+				return add(n);
+			}
+
+			constexpr bool class_item(ast_node& item)
+			{
+				if (s[pos] == '\\')
+				{
+					++pos;
+					return escape(item);
+				}
+				item.kind = ast_kind::literal;
+				item.ch = s[pos++];
+				return true;
+			}
+		};
+
+		template <std::size_t N>
+		constexpr tree<N> parse(const char* s)
+		{
+			parser<N> p(s);
+			p.run();
+			return p.t;
+		}
+
+		// Compiled program. Every state names the state to continue with, so
+		// matching is a walk from `start` to an accept state.
+		enum class op : std::uint8_t { accept, literal, set, bol, eol, repeat, split, save };
+
+		struct state
+		{
+			op kind = op::accept;
+			char ch = 0;
+			bool greedy = true;
+			charset set;
+			std::size_t next = 0;
+			std::size_t alt = 0; // split: the second choice
+			std::size_t min = 0; // repeat
+			std::size_t max = 0;
+			std::size_t slot = 0; // save: index into the capture pointers
+		};
+
+		template <std::size_t N>
+		struct program
+		{
+			state states[N] = {};
+			std::size_t count = 1; // states[0] is the accept state
+			std::size_t start = 0;
+		};
+
+		template <std::size_t N>
+		constexpr bool single_char(const tree<N>& t, std::size_t i)
+		{
+			const ast_kind k = t.nodes[i].kind;
+			return k == ast_kind::literal || k == ast_kind::any || k == ast_kind::set;
+		}
+
+		template <std::size_t N>
+		constexpr std::size_t code_size(const tree<N>& t, std::size_t i)
+		{
+			const ast_node& n = t.nodes[i];
+			switch (n.kind)
+			{
+			case ast_kind::empty:
+				return 0;
+			case ast_kind::concat:
+				return code_size(t, n.a) + code_size(t, n.b);
+			case ast_kind::alt:
+				return 1 + code_size(t, n.a) + code_size(t, n.b);
+			case ast_kind::group:
+				return code_size(t, n.a) + (n.group == npos ? 0 : 2);
+			case ast_kind::repeat:
+			{
+				if (single_char(t, n.a))
+				{
+					return 1;
+				}
+				const std::size_t body = code_size(t, n.a);
+				const std::size_t optional = n.max == npos ? 1 : n.max - n.min;
+				return n.min * body + optional * (body + 1);
+			}
+			default:
+				return 1;
+			}
+		}
+
+		template <std::size_t N>
+		constexpr std::size_t code_size(const tree<N>& t)
+		{
+			return t.err == error::none ? 1 + code_size(t, t.root) : 1;
+		}
+
+		template <std::size_t N, std::size_t M>
+		class emitter
+		{
+			const tree<N>& t;
+
+		public:
+			program<M> p;
+
+			constexpr explicit emitter(const tree<N>& t) : t(t) {}
+
+			// Emits code for node i followed by state k; returns its first state.
+			constexpr std::size_t emit(std::size_t i, std::size_t k)
+			{
+				const ast_node& n = t.nodes[i];
+				state s;
+				s.next = k;
+				switch (n.kind)
+				{
+				case ast_kind::empty:
+					return k;
+				case ast_kind::literal:
+					s.kind = op::literal;
+					s.ch = n.ch;
+					return add(s);
+				case ast_kind::any:
+				case ast_kind::set:
+					s.kind = op::set;
+					s.set = chars(n);
+					return add(s);
+				case ast_kind::bol:
+					s.kind = op::bol;
+					return add(s);
+				case ast_kind::eol:
+					s.kind = op::eol;
+					return add(s);
+				case ast_kind::concat:
+					return emit(n.a, emit(n.b, k));
+				case ast_kind::alt:
+					s.kind = op::split;
+					s.next = emit(n.a, k);
+					s.alt = emit(n.b, k);
+					return add(s);
+				case ast_kind::group:
+				{
+					if (n.group == npos)
+					{
+						return emit(n.a, k);
+					}
+					s.kind = op::save;
+					s.slot = 2 * n.group + 1;
+					const std::size_t close = add(s);
+					s.slot = 2 * n.group;
+					s.next = emit(n.a, close);
+					return add(s);
+				}
+				case ast_kind::repeat:
+					return repeat(n, k);
+				}
+				return k;
+			}
+
+		private:
+			constexpr std::size_t add(const state& s)
+			{
+				p.states[p.count] = s;
+				return p.count++;
+			}
+
+			constexpr charset chars(const ast_node& n) const
+			{
+				switch (n.kind)
+				{
+				case ast_kind::literal:
+					return single(static_cast<unsigned char>(n.ch));
+				case ast_kind::any:
+					return any_but_newline();
+				default:
+					return n.set;
+				}
+			}
+
+			constexpr std::size_t repeat(const ast_node& n, std::size_t k)
+			{
+				state s;
+				s.greedy = n.greedy;
+				if (single_char(t, n.a))
+				{
+					s.kind = op::repeat;
+					s.set = chars(t.nodes[n.a]);
+					s.min = n.min;
+					s.max = n.max;
+					s.next = k;
+					return add(s);
+				}
+				// A split prefers `next`; a lazy quantifier prefers leaving.
+				s.kind = op::split;
+				std::size_t cont = k;
+				if (n.max == npos)
+				{
+					const std::size_t loop = add(s);
+					const std::size_t body = emit(n.a, loop);
+					p.states[loop].next = n.greedy ? body : k;
+					p.states[loop].alt = n.greedy ? k : body;
+					cont = loop;
+				}
+				else
+				{
+					for (std::size_t i = n.min; i < n.max; ++i)
+					{
+						const std::size_t body = emit(n.a, cont);
+						s.next = n.greedy ? body : k;
+						s.alt = n.greedy ? k : body;
+						cont = add(s);
+					}
+				}
+				for (std::size_t i = 0; i < n.min; ++i)
+				{
+					cont = emit(n.a, cont);
+				}
+				return cont;
+			}
+		};
+
+		template <std::size_t M, std::size_t N>
+		constexpr program<M> compile(const tree<N>& t)
+		{
+			emitter<N, M> e(t);
+			if (t.err == error::none)
+			{
+				e.p.start = e.emit(t.root, 0);
+			}
+			return e.p;
+		}
+
+		// Fails to compile with a message naming the error; Pos is the offset
+		// into the pattern and shows up in the instantiation trace.
+		template <error E, std::size_t Pos>
+		struct diagnose
+		{
+			static_assert(E != error::unescaped_space, "CTREGEX: unescaped space in pattern; write \"\\\\ \" or \"[ ]\" if a space is meant");
+			static_assert(E != error::unbalanced_paren, "CTREGEX: unbalanced parenthesis");
+			static_assert(E != error::unterminated_class, "CTREGEX: '[' without a closing ']'");
+			static_assert(E != error::bad_range, "CTREGEX: character range out of order or with a class as an end point");
+			static_assert(E != error::bad_escape, "CTREGEX: unsupported escape or group type");
+			static_assert(E != error::nothing_to_repeat, "CTREGEX: quantifier with nothing to repeat");
+			static_assert(E != error::bad_quantifier, "CTREGEX: malformed {m,n} quantifier (counts are limited to 1000)");
+			static_assert(E != error::empty_loop, "CTREGEX: unbounded quantifier on a subexpression that can match the empty string");
+			static_assert(E != error::too_complex, "CTREGEX: pattern too complex");
+			static constexpr bool ok = true;
+		};
+	}
+
+	// Result of match() or search(). (*this)[0] is the whole match and
+	// (*this)[i] the i-th group; a group that did not take part is empty.
+	template <std::size_t Groups>
+	class match_result
+	{
+		template <typename Source>
+		friend class regex;
+
+		const char* caps[2 * (Groups + 1)] = {};
+
+	public:
+		constexpr explicit operator bool() const { return caps[0] != nullptr; }
+		static constexpr std::size_t size() { return Groups + 1; }
+
+		constexpr bool matched(std::size_t i) const { return caps[2 * i] != nullptr && caps[2 * i + 1] != nullptr; }
+
+		constexpr std::string_view operator[](std::size_t i) const
+		{
+			return matched(i) ? std::string_view(caps[2 * i], std::size_t(caps[2 * i + 1] - caps[2 * i])) : std::string_view();
+		}
+
+		std::string str(std::size_t i = 0) const { return std::string((*this)[i]); }
+	};
+
+	// Source is a type with static constexpr const char* text(); CTREGEX makes one.
+	template <typename Source>
+	class regex
+	{
+		static constexpr const char* pattern = Source::text();
+		static constexpr auto tree = detail::parse<detail::tree_capacity(detail::length(pattern))>(pattern);
+		static_assert(detail::diagnose<tree.err, tree.err_pos>::ok, "invalid CTREGEX pattern");
+		static constexpr auto prog = detail::compile<detail::code_size(tree)>(tree);
+
+		static constexpr std::size_t groups = tree.groups;
+		using result = match_result<groups>;
+
+		struct context
+		{
+			const char* begin;
+			const char* end;
+			result& r;
+		};
+
+		template <std::size_t I, bool Full>
+		static constexpr bool run(const char* p, context& ctx)
+		{
+			constexpr detail::state s = prog.states[I];
+			if constexpr (s.kind == detail::op::accept)
+			{
+				if constexpr (Full)
+				{
+					if (p != ctx.end)
+					{
+						return false;
+					}
+				}
+				ctx.r.caps[1] = p;
+				return true;
+			}
+			else if constexpr (s.kind == detail::op::literal)
+			{
+				return p != ctx.end && *p == s.ch && run<s.next, Full>(p + 1, ctx);
+			}
+			else if constexpr (s.kind == detail::op::set)
+			{
+				return p != ctx.end && s.set.test(static_cast<unsigned char>(*p)) && run<s.next, Full>(p + 1, ctx);
+			}
+			else if constexpr (s.kind == detail::op::bol)
+			{
+				return p == ctx.begin && run<s.next, Full>(p, ctx);
+			}
+			else if constexpr (s.kind == detail::op::eol)
+			{
+				return p == ctx.end && run<s.next, Full>(p, ctx);
+			}
+			else if constexpr (s.kind == detail::op::split)
+			{
+				return run<s.next, Full>(p, ctx) || run<s.alt, Full>(p, ctx);
+			}
+			else if constexpr (s.kind == detail::op::save)
+			{
+				const char* old = ctx.r.caps[s.slot];
+				ctx.r.caps[s.slot] = p;
+				if (run<s.next, Full>(p, ctx))
+				{
+					return true;
+				}
+				ctx.r.caps[s.slot] = old;
+				return false;
+			}
+			else
+			{
+				return repeat<I, Full>(p, ctx);
+			}
+		}
+
+		// Repetition of one character class: scan in a loop, then back off.
+		template <std::size_t I, bool Full>
+		static constexpr bool repeat(const char* p, context& ctx)
+		{
+			constexpr detail::state s = prog.states[I];
+			constexpr detail::state after = prog.states[s.next];
+			// Backing off cannot help when the next state needs a character
+			// this class never matches, or when it is the final accept.
+			constexpr bool one_try = after.kind == detail::op::accept
+				|| (after.kind == detail::op::literal && !s.set.test(static_cast<unsigned char>(after.ch)))
+				|| (after.kind == detail::op::set && s.set.disjoint(after.set));
+			const std::size_t avail = std::size_t(ctx.end - p);
+			const std::size_t limit = s.max < avail ? s.max : avail;
+			if constexpr (s.greedy)
+			{
+				std::size_t n = 0;
+				while (n < limit && s.set.test(static_cast<unsigned char>(p[n])))
+				{
+					++n;
+				}
+				if (n < s.min)
+				{
+					return false;
+				}
+				if constexpr (one_try)
+				{
+					return run<s.next, Full>(p + n, ctx);
+				}
+				for (;; --n)
+				{
+					if (run<s.next, Full>(p + n, ctx))
+					{
+						return true;
+					}
+					if (n == s.min)
+					{
+						return false;
+					}
+				}
+			}
+			else
+			{
+				std::size_t n = 0;
+				for (; n < s.min; ++n)
+				{
+					if (n == limit || !s.set.test(static_cast<unsigned char>(p[n])))
+					{
+						return false;
+					}
+				}
+				for (;; ++n)
+				{
+					if (run<s.next, Full>(p + n, ctx))
+					{
+						return true;
+					}
+					if (n == limit || !s.set.test(static_cast<unsigned char>(p[n])))
+					{
+						return false;
+					}
+				}
+			}
+		}
+
+	public:
+		static constexpr std::size_t group_count() { return groups; }
+		static constexpr std::string_view source() { return pattern; }
+
+		// The whole of `text` must match.
+		static constexpr result match(std::string_view text)
+		{
+			result r;
+			const char* begin = text.data() ? text.data() : "";
+			context ctx{ begin, begin + text.size(), r };
+			r.caps[0] = begin;
+			if (!run<prog.start, true>(begin, ctx))
+			{
+				return result();
+			}
+			return r;
+		}
+
+		// First match anywhere in `text`, preferring the leftmost start.
+		static constexpr result search(std::string_view text)
+		{
+			result r;
+			const char* begin = text.data() ? text.data() : "";
+			context ctx{ begin, begin + text.size(), r };
+			for (const char* p = begin;; ++p)
+			{
+				if constexpr (prog.states[prog.start].kind == detail::op::literal)
+				{
+					// Skip straight to the next occurrence of the first character.
+					p = std::char_traits<char>::find(p, std::size_t(ctx.end - p), prog.states[prog.start].ch);
+					if (!p)
+					{
+						return result();
+					}
+				}
+				r.caps[0] = p;
+				if (run<prog.start, false>(p, ctx))
+				{
+					return r;
+				}
+				if (p == ctx.end)
+				{
+					return result();
+				}
+				r = result();
+			}
+		}
+	};
+
+	// Parses `pattern` without instantiating a matcher, for tests of the
+	// diagnostics themselves.
+	template <std::size_t N>
+	constexpr error check(const char (&pattern)[N])
+	{
+		return detail::parse<detail::tree_capacity(N)>(pattern).err;
+	}
+}
+
+// A compile-time regex for a string-literal pattern, e.g.
+//   constexpr auto re = CTREGEX("([a-z]+)\\.txt");
+//   if (auto m = re.match(name)) use(m[1]);
+#define CTREGEX(pattern) ([] { \
+	struct ctregex_source { static constexpr const char* text() { return pattern; } }; \
+	return ::ctregex::regex<ctregex_source>(); }())
@@ -0,0 +1,348 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <filesystem>
+#endif
+
+#include "FlatHash.h"
+
+/*
+Parallel directory scanning
+dirscan::scan(root, visit) walks a directory tree on several threads and calls visit(worker, dir, name) for every entry that is not a directory. Each worker owns a deque of directories still to be read. It takes work from the back of its own deque, so it goes depth-first and stays near the directories it just read. An idle worker steals from the front of another worker's deque, where the oldest and usually largest subtrees wait.
+
+On Linux a directory is read with getdents64 into a 64 KiB per-thread buffer, so one system call returns hundreds of entries, and the entry type comes back with the name, with no stat per file. Other platforms use std::filesystem::directory_iterator. Directory paths are copied into per-thread arenas that live until the scan ends, so queued work items are plain string_views. The name passed to visit points into the read buffer and is only valid during the call.
+
+Symbolic links are reported as entries and never followed, so a link cycle cannot make the scan loop. Unreadable directories are counted in stats::errors and skipped.
+
+count_captures(root, re) feeds every name to a CTREGEX matcher and counts the matches by the text of one capture group.
+*/
+namespace dirscan
+{
+	struct stats
+	{
+		std::size_t files = 0;
+		std::size_t directories = 0;
+		std::size_t errors = 0;
+	};
+
+	inline std::size_t worker_count(std::size_t threads)
+	{
+		return threads != 0 ? threads : std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	}
+
+	namespace detail
+	{
+		// Bump allocator for strings; everything is freed with the arena.
+		class arena
+		{
+			static constexpr std::size_t block_size = 64 * 1024;
+			std::vector<std::unique_ptr<char[]>> blocks;
+			char* cursor = nullptr;
+			std::size_t left = 0;
+
+		public:
+			// Stores a + '/' + b (just a if b is empty).
+			std::string_view join(std::string_view a, std::string_view b)
+			{
+				const bool sep = !b.empty() && !a.empty() && a.back() != '/';
+				const std::size_t n = a.size() + (sep ? 1 : 0) + b.size();
+				if (n > left)
+				{
+					const std::size_t size = std::max(block_size, n);
+					blocks.emplace_back(new char[size]);
+					cursor = blocks.back().get();
+					left = size;
+				}
+				char* out = cursor;
+				std::memcpy(out, a.data(), a.size());
+				if (sep)
+				{
+					out[a.size()] = '/';
+				}
+				if (!b.empty())
+				{
+					std::memcpy(out + a.size() + (sep ? 1 : 0), b.data(), b.size());
+				}
+				cursor += n;
+				left -= n;
+				return std::string_view(out, n);
+			}
+		};
+
+		struct alignas(64) worker
+		{
+			std::mutex lock;
+			std::deque<std::string_view> dirs;
+			arena paths;
+			stats counts;
+		};
+
+		class scanner
+		{
+			std::vector<std::unique_ptr<worker>> workers;
+			std::atomic<std::size_t> pending{ 0 }; // directories queued or being read
+
+		public:
+			explicit scanner(std::size_t n)
+			{
+				for (std::size_t i = 0; i < n; ++i)
+				{
+					workers.emplace_back(new worker);
+				}
+			}
+
+			std::size_t size() const { return workers.size(); }
+
+			void push(std::size_t self, std::string_view dir)
+			{
+				worker& w = *workers[self];
+				pending.fetch_add(1, std::memory_order_relaxed);
+				std::lock_guard<std::mutex> lk(w.lock);
+				w.dirs.push_back(dir);
+			}
+
+			std::string_view join(std::size_t self, std::string_view a, std::string_view b)
+			{
+				return workers[self]->paths.join(a, b);
+			}
+
+			stats& counts(std::size_t self) { return workers[self]->counts; }
+
+			template <typename Read>
+			void run(std::size_t self, Read& read)
+			{
+				std::string_view dir;
+				for (;;)
+				{
+					if (take(self, dir))
+					{
+						read(self, dir);
+						pending.fetch_sub(1, std::memory_order_acq_rel);
+					}
+					else if (pending.load(std::memory_order_acquire) == 0)
+					{
+						return;
+					}
+					else
+					{
+						std::this_thread::yield();
+					}
+				}
+			}
+
+			stats total() const
+			{
+				stats s;
+				for (auto& w : workers)
+				{
+					s.files += w->counts.files;
+					s.directories += w->counts.directories;
+					s.errors += w->counts.errors;
+				}
+				return s;
+			}
+
+		private:
+			// Own deque from the back, then the others' from the front.
+			bool take(std::size_t self, std::string_view& dir)
+			{
+				{
+					worker& w = *workers[self];
+					std::lock_guard<std::mutex> lk(w.lock);
+					if (!w.dirs.empty())
+					{
+						dir = w.dirs.back();
+						w.dirs.pop_back();
+						return true;
+					}
+				}
+				for (std::size_t i = 1; i < workers.size(); ++i)
+				{
+					worker& victim = *workers[(self + i) % workers.size()];
+					std::lock_guard<std::mutex> lk(victim.lock);
+					if (!victim.dirs.empty())
+					{
+						dir = victim.dirs.front();
+						victim.dirs.pop_front();
+						return true;
+					}
+				}
+				return false;
+			}
+		};
+
+		inline bool is_dot(std::string_view name) { return name == "." || name == ".."; }
+
+#if defined(__linux__)
+		constexpr std::size_t read_buffer_size = 64 * 1024;
+
+		// Calls fn(name, is_dir) for each entry of one directory.
+		template <typename Fn>
+		bool list(std::string_view dir, char* buffer, std::string& cpath, Fn&& fn)
+		{
+			cpath.assign(dir.data(), dir.size()); // open() needs a terminated string
+			const int fd = ::open(cpath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+			if (fd < 0)
+			{
+				return false;
+			}
+			for (;;)
+			{
+				const long n = ::syscall(SYS_getdents64, fd, buffer, read_buffer_size);
+				if (n <= 0)
+				{
+					::close(fd);
+					return n == 0;
+				}
+				// struct linux_dirent64: u64 ino, s64 off, u16 reclen, u8 type, char name[].
+				for (long off = 0; off < n;)
+				{
+					const char* rec = buffer + off;
+					unsigned short reclen;
+					std::memcpy(&reclen, rec + 16, sizeof reclen);
+					const unsigned char type = static_cast<unsigned char>(rec[18]);
+					const char* name = rec + 19;
+					const std::string_view sv(name);
+					off += reclen;
+					if (is_dot(sv))
+					{
+						continue;
+					}
+					bool is_dir = type == DT_DIR;
+					if (type == DT_UNKNOWN)
+					{
+						// Some file systems do not fill in d_type.
+						struct stat st;
+						is_dir = ::fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0 && S_ISDIR(st.st_mode);
+					}
+					fn(sv, is_dir);
+				}
+			}
+		}
+#else
+		template <typename Fn>
+		bool list(std::string_view dir, char*, std::string&, Fn&& fn)
+		{
+			std::error_code ec;
+			std::filesystem::directory_iterator it(std::filesystem::u8path(dir.begin(), dir.end()), ec), end;
+			for (; !ec && it != end; it.increment(ec))
+			{
+				const std::string name = it->path().filename().u8string();
+				const bool is_dir = it->symlink_status(ec).type() == std::filesystem::file_type::directory;
+				fn(std::string_view(name), is_dir);
+			}
+			return !ec;
+		}
+#endif
+	}
+
+	// Calls visit(worker, dir, name) for every non-directory entry under root,
+	// from `threads` threads (0 = one per hardware thread). Calls made with the
+	// same worker index never overlap, so per-worker state needs no lock.
+	template <typename Visit>
+	stats scan(std::string_view root, Visit&& visit, std::size_t threads = 0)
+	{
+		detail::scanner s(worker_count(threads));
+		s.push(0, s.join(0, root, {}));
+
+		auto body = [&](std::size_t self) {
+#if defined(__linux__)
+			std::unique_ptr<char[]> buffer(new char[detail::read_buffer_size]);
+#else
+			std::unique_ptr<char[]> buffer;
+#endif
+			std::string cpath;
+			auto read = [&](std::size_t me, std::string_view dir) {
+				stats& counts = s.counts(me);
+				++counts.directories;
+				const bool ok = detail::list(dir, buffer.get(), cpath, [&](std::string_view name, bool is_dir) {
+					if (is_dir)
+					{
+						s.push(me, s.join(me, dir, name));
+					}
+					else
+					{
+						++counts.files;
+						visit(me, dir, name);
+					}
+				});
+				if (!ok)
+				{
+					++counts.errors;
+				}
+			};
+			s.run(self, read);
+		};
+
+		std::vector<std::thread> pool;
+		for (std::size_t i = 1; i < s.size(); ++i)
+		{
+			pool.emplace_back(body, i);
+		}
+		body(0);
+		for (auto& t : pool)
+		{
+			t.join();
+		}
+		return s.total();
+	}
+
+	// Matches every file name under root against `re` (a CTREGEX) and counts
+	// the matches by the text of capture `group`.
+	template <typename Regex>
+	flathash::flat_hash_map<std::string, std::size_t> count_captures(std::string_view root, const Regex& re, std::size_t group = 1, std::size_t threads = 0, stats* out = nullptr)
+	{
+		struct alignas(64) tally
+		{
+			flathash::flat_hash_map<std::string, std::size_t> counts;
+		};
+		std::vector<tally> tallies(worker_count(threads));
+		const stats st = scan(root, [&](std::size_t worker, std::string_view, std::string_view name) {
+			if (auto m = re.match(name))
+			{
+				auto& counts = tallies[worker].counts;
+				const std::string_view key = m[group];
+				auto it = counts.find(key);
+				if (it != counts.end())
+				{
+					++it->second;
+				}
+				else
+				{
+					counts.try_emplace(std::string(key), 1);
+				}
+			}
+		}, threads);
+		if (out)
+		{
+			*out = st;
+		}
+
+		auto& merged = tallies[0].counts;
+		for (std::size_t i = 1; i < tallies.size(); ++i)
+		{
+			for (auto& kv : tallies[i].counts)
+			{
+				merged[kv.first] += kv.second;
+			}
+		}
+		return std::move(merged);
+	}
+}
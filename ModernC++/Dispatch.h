@@ -0,0 +1,164 @@
+#pragma once
+#include <cstddef>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+#include <vector>
+
+/*
+Polymorphic dispatch
+A1/B1 and A2/B2 show override and final. This header puts the same small interface, shape::area(), behind the three kinds of dispatch those keywords lead to, so their costs can be compared on the same data.
+
+Virtual: boxed<T> overrides shape::area(). Every call loads the vtable pointer and makes an indirect call, which the compiler cannot inline. When consecutive objects have different types, the indirect branch is also hard to predict.
+
+Final: sealed<T> is a final override. Through a sealed<T>& the compiler knows the exact function and calls, or inlines, it directly. devirtualize<sealed<X>, sealed<Y>>(s, fn) turns a shape& into one of those references with a type check (guarded devirtualization, what profile-guided optimization does for hot call sites). Types not in the list fall back to the virtual call.
+
+Variant: closed<Ts...> is a std::variant of the plain types, a hierarchy that cannot be extended. Objects are stored by value, with no heap allocation and no vtable. visit_batched() and reduce_batched() find runs of equal alternatives and call fn in a loop that has only one type in it, so sorted or clustered data pays for one branch per run instead of one per element.
+*/
+namespace dispatch
+{
+	struct shape
+	{
+		virtual ~shape() = default;
+		virtual double area() const = 0;
+	};
+
+	// T is a plain type with a non-virtual area().
+	template <typename T>
+	struct boxed : shape
+	{
+		T value;
+		explicit boxed(T v) : value(std::move(v)) {}
+		double area() const override { return value.area(); }
+	};
+
+	template <typename T>
+	struct sealed final : shape
+	{
+		T value;
+		explicit sealed(T v) : value(std::move(v)) {}
+		double area() const override { return value.area(); }
+	};
+
+	namespace detail
+	{
+		// Compares type_info addresses rather than calling operator==, which may
+		// compare names. A type with several type_info objects (one per shared
+		// library) only misses the fast path.
+		template <typename D, typename... Ds, typename Fn>
+		decltype(auto) devirtualize(const shape& s, const std::type_info* dynamic, Fn& fn)
+		{
+			if (dynamic == &typeid(D))
+			{
+				return fn(static_cast<const D&>(s));
+			}
+			if constexpr (sizeof...(Ds) > 0)
+			{
+				return devirtualize<Ds...>(s, dynamic, fn);
+			}
+			else
+			{
+				return fn(s);
+			}
+		}
+	}
+
+	// Calls fn with the first listed type that s really is, or with s itself.
+	// Each listed type must be final, otherwise fn(D&) could still dispatch
+	// to a further override.
+	template <typename... Ds, typename Fn>
+	decltype(auto) devirtualize(const shape& s, Fn&& fn)
+	{
+		static_assert((std::is_final<Ds>::value && ...), "devirtualize only helps with final classes");
+		return detail::devirtualize<Ds...>(s, &typeid(s), fn);
+	}
+
+	template <typename... Ts>
+	using closed = std::variant<Ts...>;
+
+	namespace detail
+	{
+		// Visits elements while they hold alternative I; returns where it stopped.
+		template <std::size_t I, typename Variant, typename Fn>
+		const Variant* run(const Variant* first, const Variant* last, Fn& fn)
+		{
+			for (; first != last && first->index() == I; ++first)
+			{
+				fn(*std::get_if<I>(first));
+			}
+			return first;
+		}
+
+		template <typename Variant, typename Fn, std::size_t... I>
+		const Variant* run(std::size_t index, const Variant* first, const Variant* last, Fn& fn, std::index_sequence<I...>)
+		{
+			using runner = const Variant* (*)(const Variant*, const Variant*, Fn&);
+			static constexpr runner table[] = { &run<I, Variant, Fn>... };
+			return table[index](first, last, fn);
+		}
+
+		// Same, adding fn's results to acc. The sum is kept in a local, which the
+		// compiler can hold in a register; a visitor adding to a captured
+		// double& must store it on every element, because the reference could
+		// alias the elements' own doubles.
+		template <std::size_t I, typename Variant, typename T, typename Fn>
+		const Variant* run_reduce(const Variant* first, const Variant* last, T& acc, Fn& fn)
+		{
+			T sum = acc;
+			for (; first != last && first->index() == I; ++first)
+			{
+				sum = sum + fn(*std::get_if<I>(first));
+			}
+			acc = sum;
+			return first;
+		}
+
+		template <typename Variant, typename T, typename Fn, std::size_t... I>
+		const Variant* run_reduce(std::size_t index, const Variant* first, const Variant* last, T& acc, Fn& fn, std::index_sequence<I...>)
+		{
+			using runner = const Variant* (*)(const Variant*, const Variant*, T&, Fn&);
+			static constexpr runner table[] = { &run_reduce<I, Variant, T, Fn>... };
+			return table[index](first, last, acc, fn);
+		}
+	}
+
+	// Calls fn(alternative) for every element. Dispatch happens once per run of
+	// equal alternatives; the run is then visited in a loop over one type.
+	// Valueless elements are skipped.
+	template <typename... Ts, typename Fn>
+	void visit_batched(const std::vector<closed<Ts...>>& items, Fn&& fn)
+	{
+		const closed<Ts...>* p = items.data();
+		const closed<Ts...>* end = p + items.size();
+		while (p != end)
+		{
+			const std::size_t index = p->index();
+			if (index == std::variant_npos)
+			{
+				++p;
+				continue;
+			}
+			p = detail::run(index, p, end, fn, std::index_sequence_for<Ts...>());
+		}
+	}
+
+	// init + fn(x) for every element x, dispatched the same way.
+	template <typename... Ts, typename T, typename Fn>
+	T reduce_batched(const std::vector<closed<Ts...>>& items, T init, Fn&& fn)
+	{
+		const closed<Ts...>* p = items.data();
+		const closed<Ts...>* end = p + items.size();
+		while (p != end)
+		{
+			const std::size_t index = p->index();
+			if (index == std::variant_npos)
+			{
+				++p;
+				continue;
+			}
+			p = detail::run_reduce(index, p, end, init, fn, std::index_sequence_for<Ts...>());
+		}
+		return init;
+	}
+}
@@ -0,0 +1,582 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+/*
+Asynchronous logging
+FASTLOG("x = {}, y = {}")(x, y) replaces std::cout << ... << std::endl on hot paths. The number of {} placeholders is checked against the argument count at compile time, and the call only copies the raw arguments into a lock-free ring buffer owned by the calling thread. A background writer thread drains every buffer, and the formatting happens there (text mode) or offline (binary mode, read back with fastlog::decode).
+
+Call fastlog::start_text(std::cout) or fastlog::start_binary("app.mclog") first and fastlog::stop() to flush. While no writer is running, FASTLOG calls are dropped. The writer runs on its own thread, so anything else written straight to the same stream is not ordered with the log lines.
+*/
+namespace fastlog
+{
+	enum class arg_type : std::uint8_t { i64, u64, f64, boolean, character, string };
+
+	constexpr std::size_t count_placeholders(const char* fmt)
+	{
+		std::size_t n = 0;
+		for (; *fmt != '\0'; ++fmt)
+		{
+			if (fmt[0] == '{' && fmt[1] == '}')
+			{
+				++n;
+				++fmt;
+			}
+		}
+		return n;
+	}
+
+	namespace detail
+	{
+		constexpr std::uint32_t pad_site = 0xffffffffu;
+		constexpr std::size_t max_string = 1024;
+		constexpr std::size_t header_size = 16; // u32 size, u32 site, u64 timestamp
+
+		template <typename T>
+		constexpr arg_type tag_of()
+		{
+			using U = std::decay_t<T>;
+			if constexpr (std::is_same<U, bool>::value) return arg_type::boolean;
+			else if constexpr (std::is_same<U, char>::value) return arg_type::character;
+			else if constexpr (std::is_integral<U>::value && std::is_signed<U>::value) return arg_type::i64;
+			else if constexpr (std::is_integral<U>::value || std::is_enum<U>::value) return arg_type::u64;
+			else if constexpr (std::is_floating_point<U>::value) return arg_type::f64;
+			else
+			{
+				static_assert(std::is_convertible<U, std::string_view>::value, "FASTLOG arguments must be arithmetic or string-like");
+				return arg_type::string;
+			}
+		}
+
+		template <typename T>
+		std::size_t encoded_size(const T& v)
+		{
+			if constexpr (tag_of<T>() == arg_type::string)
+			{
+				return 4 + std::min(std::string_view(v).size(), max_string);
+			}
+			else if constexpr (tag_of<T>() == arg_type::boolean || tag_of<T>() == arg_type::character)
+			{
+				return 1;
+			}
+			else
+			{
+				return 8;
+			}
+		}
+
+		template <typename T>
+		char* encode(char* out, const T& v)
+		{
+			constexpr arg_type tag = tag_of<T>();
+			if constexpr (tag == arg_type::string)
+			{
+				const std::string_view s(v);
+				const std::uint32_t n = static_cast<std::uint32_t>(std::min(s.size(), max_string));
+				std::memcpy(out, &n, 4);
+				std::memcpy(out + 4, s.data(), n);
+				return out + 4 + n;
+			}
+			else if constexpr (tag == arg_type::boolean || tag == arg_type::character)
+			{
+				*out = static_cast<char>(v);
+				return out + 1;
+			}
+			else
+			{
+				using Wide = std::conditional_t<tag == arg_type::i64, std::int64_t,
+					std::conditional_t<tag == arg_type::u64, std::uint64_t, double>>;
+				const Wide w = static_cast<Wide>(v);
+				std::memcpy(out, &w, 8);
+				return out + 8;
+			}
+		}
+
+		// Formats one record's payload into `out` following the site's format string.
+		inline void format(std::string& out, std::string_view fmt, const std::vector<arg_type>& tags, const char* payload)
+		{
+			std::size_t arg = 0;
+			char num[32];
+			for (std::size_t i = 0; i < fmt.size(); ++i)
+			{
+				if (fmt[i] != '{' || i + 1 >= fmt.size() || fmt[i + 1] != '}' || arg >= tags.size())
+				{
+					out += fmt[i];
+					continue;
+				}
+				++i;
+				switch (tags[arg++])
+				{
+				case arg_type::i64:
+				{
+					std::int64_t v;
+					std::memcpy(&v, payload, 8);
+					payload += 8;
+					out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+					break;
+				}
+				case arg_type::u64:
+				{
+					std::uint64_t v;
+					std::memcpy(&v, payload, 8);
+					payload += 8;
+					out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+					break;
+				}
+				case arg_type::f64:
+				{
+					double v;
+					std::memcpy(&v, payload, 8);
+					payload += 8;
+					out.append(num, std::to_chars(num, num + sizeof(num), v).ptr);
+					break;
+				}
+				case arg_type::boolean:
+					out += *payload++ ? "1" : "0";
+					break;
+				case arg_type::character:
+					out += *payload++;
+					break;
+				case arg_type::string:
+				{
+					std::uint32_t n;
+					std::memcpy(&n, payload, 4);
+					out.append(payload + 4, n);
+					payload += 4 + n;
+					break;
+				}
+				}
+			}
+		}
+
+		// Single-producer/single-consumer byte ring. The owning thread appends
+		// records; only the writer thread consumes them.
+		class ring
+		{
+		public:
+			static constexpr std::size_t capacity = 1 << 20;
+
+			ring() : buf(new char[capacity]) {}
+
+			// Returns space for `size` contiguous bytes, spinning while the writer
+			// catches up, or null if `open` turns false while it waits: the writer
+			// is stopping and would never free the space.
+			char* reserve(std::size_t size, const std::atomic<bool>& open)
+			{
+				const std::uint64_t pos = head.load(std::memory_order_relaxed);
+				const std::size_t offset = static_cast<std::size_t>(pos & (capacity - 1));
+				const std::size_t pad = offset + size > capacity ? capacity - offset : 0;
+				while (capacity - (pos - cached_tail) < pad + size)
+				{
+					cached_tail = tail.load(std::memory_order_acquire);
+					if (capacity - (pos - cached_tail) < pad + size)
+					{
+						if (!open.load(std::memory_order_acquire))
+						{
+							return nullptr;
+						}
+						std::this_thread::yield();
+					}
+				}
+				if (pad != 0)
+				{
+					const std::uint32_t header[2] = { static_cast<std::uint32_t>(pad), pad_site };
+					std::memcpy(buf.get() + offset, header, sizeof(header));
+				}
+				reserved = pad + size;
+				return buf.get() + (pad != 0 ? 0 : offset);
+			}
+
+			void commit()
+			{
+				head.store(head.load(std::memory_order_relaxed) + reserved, std::memory_order_release);
+			}
+
+			// Calls fn(site, timestamp, payload) for every committed record.
+			template <typename Fn>
+			bool drain(Fn&& fn)
+			{
+				std::uint64_t t = tail.load(std::memory_order_relaxed);
+				const std::uint64_t h = head.load(std::memory_order_acquire);
+				if (t == h)
+				{
+					return false;
+				}
+				while (t != h)
+				{
+					const char* rec = buf.get() + (t & (capacity - 1));
+					std::uint32_t size, site;
+					std::memcpy(&size, rec, 4);
+					std::memcpy(&site, rec + 4, 4);
+					if (site != pad_site)
+					{
+						std::uint64_t ts;
+						std::memcpy(&ts, rec + 8, 8);
+						fn(site, ts, rec + header_size, size - header_size);
+					}
+					t += size;
+				}
+				tail.store(t, std::memory_order_release);
+				return true;
+			}
+
+			bool empty() const
+			{
+				return tail.load(std::memory_order_relaxed) == head.load(std::memory_order_acquire);
+			}
+
+			std::atomic<bool> retired{ false };
+			// Set by the owning thread while it writes a record; see logger::stop().
+			std::atomic<bool> busy{ false };
+
+		private:
+			std::unique_ptr<char[]> buf;
+			alignas(64) std::atomic<std::uint64_t> head{ 0 };
+			std::uint64_t cached_tail = 0;
+			std::size_t reserved = 0;
+			alignas(64) std::atomic<std::uint64_t> tail{ 0 };
+		};
+
+		struct site_info
+		{
+			std::string fmt;
+			std::vector<arg_type> tags;
+		};
+
+		class logger
+		{
+		public:
+			static logger& instance()
+			{
+				static logger l;
+				return l;
+			}
+
+			std::atomic<bool> running{ false };
+
+			std::uint32_t add_site(const char* fmt, std::vector<arg_type> tags)
+			{
+				std::lock_guard<std::mutex> lk(m);
+				sites.push_back({ fmt, std::move(tags) });
+				return static_cast<std::uint32_t>(sites.size() - 1);
+			}
+
+			ring& local_ring()
+			{
+				struct holder
+				{
+					std::shared_ptr<ring> r = std::make_shared<ring>();
+					holder() { logger::instance().adopt(r); }
+					~holder() { r->retired.store(true, std::memory_order_release); }
+				};
+				thread_local holder h;
+				return *h.r;
+			}
+
+			void start(std::ostream* text, std::unique_ptr<std::ofstream> binary)
+			{
+				stop();
+				textOut = text;
+				binaryOut = std::move(binary);
+				if (binaryOut)
+				{
+					binaryOut->write("MCLOG1\n", 7);
+				}
+				written.clear();
+				quit.store(false);
+				running.store(true, std::memory_order_release);
+				writer = std::thread([this] { run(); });
+			}
+
+			void stop()
+			{
+				if (!writer.joinable())
+				{
+					return;
+				}
+				running.store(false, std::memory_order_seq_cst);
+				// A producer marks its ring busy before it checks `running`, so one
+				// that saw true is still busy here. Let it finish; the writer keeps
+				// draining meanwhile and its record is not lost.
+				for (;;)
+				{
+					bool busy = false;
+					{
+						std::lock_guard<std::mutex> lk(m);
+						for (auto& r : rings)
+						{
+							busy |= r->busy.load(std::memory_order_seq_cst);
+						}
+					}
+					if (!busy)
+					{
+						break;
+					}
+					std::this_thread::yield();
+				}
+				quit.store(true);
+				writer.join();
+				if (binaryOut) binaryOut->flush();
+				if (textOut) textOut->flush();
+				binaryOut.reset();
+				textOut = nullptr;
+			}
+
+			~logger() { stop(); }
+
+		private:
+			void adopt(std::shared_ptr<ring> r)
+			{
+				std::lock_guard<std::mutex> lk(m);
+				rings.push_back(std::move(r));
+			}
+
+			site_info site(std::uint32_t id)
+			{
+				std::lock_guard<std::mutex> lk(m);
+				return sites[id];
+			}
+
+			void run()
+			{
+				std::string line;
+				for (;;)
+				{
+					const bool last = quit.load();
+					std::vector<std::shared_ptr<ring>> snapshot;
+					{
+						std::lock_guard<std::mutex> lk(m);
+						snapshot = rings;
+					}
+					bool any = false;
+					for (auto& r : snapshot)
+					{
+						any |= r->drain([&](std::uint32_t id, std::uint64_t ts, const char* payload, std::size_t size) {
+							emit(id, ts, payload, size, line);
+						});
+					}
+					{
+						// Drop buffers whose thread has exited once they are empty.
+						std::lock_guard<std::mutex> lk(m);
+						for (auto it = rings.begin(); it != rings.end();)
+						{
+							if ((*it)->retired.load(std::memory_order_acquire) && (*it)->empty())
+								it = rings.erase(it);
+							else
+								++it;
+						}
+					}
+					if (last)
+					{
+						break;
+					}
+					if (!any)
+					{
+						std::this_thread::sleep_for(std::chrono::microseconds(200));
+					}
+				}
+			}
+
+			void emit(std::uint32_t id, std::uint64_t ts, const char* payload, std::size_t size, std::string& line)
+			{
+				auto it = written.find(id);
+				if (it == written.end())
+				{
+					it = written.emplace(id, site(id)).first;
+					if (binaryOut)
+					{
+						write_site(*binaryOut, id, it->second);
+					}
+				}
+				if (binaryOut)
+				{
+					const std::uint32_t n = static_cast<std::uint32_t>(size);
+					binaryOut->put('R');
+					binaryOut->write(reinterpret_cast<const char*>(&id), 4);
+					binaryOut->write(reinterpret_cast<const char*>(&ts), 8);
+					binaryOut->write(reinterpret_cast<const char*>(&n), 4);
+					binaryOut->write(payload, n);
+				}
+				if (textOut)
+				{
+					line.clear();
+					format(line, it->second.fmt, it->second.tags, payload);
+					line += '\n';
+					textOut->write(line.data(), static_cast<std::streamsize>(line.size()));
+				}
+			}
+
+			static void write_site(std::ostream& out, std::uint32_t id, const site_info& s)
+			{
+				const std::uint32_t len = static_cast<std::uint32_t>(s.fmt.size());
+				const std::uint32_t argc = static_cast<std::uint32_t>(s.tags.size());
+				out.put('S');
+				out.write(reinterpret_cast<const char*>(&id), 4);
+				out.write(reinterpret_cast<const char*>(&len), 4);
+				out.write(s.fmt.data(), len);
+				out.write(reinterpret_cast<const char*>(&argc), 4);
+				out.write(reinterpret_cast<const char*>(s.tags.data()), argc);
+			}
+
+			std::mutex m;
+			std::deque<site_info> sites;
+			std::vector<std::shared_ptr<ring>> rings;
+			std::unordered_map<std::uint32_t, site_info> written;
+			std::ostream* textOut = nullptr;
+			std::unique_ptr<std::ofstream> binaryOut;
+			std::atomic<bool> quit{ false };
+			std::thread writer;
+		};
+
+		template <std::size_t Expected, typename FmtFn>
+		class call_site
+		{
+			FmtFn fmt;
+
+		public:
+			constexpr explicit call_site(FmtFn f) : fmt(f) {}
+
+			template <typename... Args>
+			void operator()(const Args&... args) const
+			{
+				static_assert(Expected == sizeof...(Args), "FASTLOG: placeholder count does not match the argument count");
+				logger& l = logger::instance();
+				if (!l.running.load(std::memory_order_relaxed))
+				{
+					return;
+				}
+				ring& r = l.local_ring();
+				struct busy_mark
+				{
+					ring& r;
+					explicit busy_mark(ring& r) : r(r) { r.busy.store(true, std::memory_order_seq_cst); }
+					~busy_mark() { r.busy.store(false, std::memory_order_release); }
+				} mark(r);
+				if (!l.running.load(std::memory_order_seq_cst))
+				{
+					return;
+				}
+				// One registration per call site and argument signature.
+				static const std::uint32_t id = l.add_site(fmt(), { tag_of<Args>()... });
+				const std::size_t payload = (std::size_t(0) + ... + encoded_size(args));
+				const std::size_t size = (header_size + payload + 7) & ~std::size_t(7);
+				char* out = r.reserve(size, l.running);
+				if (!out)
+				{
+					return; // stopped while the ring was full: dropped
+				}
+				const std::uint32_t header[2] = { static_cast<std::uint32_t>(size), id };
+				const std::uint64_t ts = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+				std::memcpy(out, header, 8);
+				std::memcpy(out + 8, &ts, 8);
+				out += header_size;
+				((out = encode(out, args)), ...);
+				r.commit();
+			}
+		};
+
+		template <std::size_t Expected, typename FmtFn>
+		constexpr call_site<Expected, FmtFn> make_call_site(FmtFn f)
+		{
+			return call_site<Expected, FmtFn>(f);
+		}
+	}
+
+	// Starts a writer that formats every record as a line of text on `out`.
+	inline void start_text(std::ostream& out)
+	{
+		detail::logger::instance().start(&out, nullptr);
+	}
+
+	// Starts a writer that appends raw records to `path` for fastlog::decode.
+	inline bool start_binary(const std::string& path)
+	{
+		auto file = std::make_unique<std::ofstream>(path, std::ios::binary | std::ios::trunc);
+		if (!*file)
+		{
+			return false;
+		}
+		detail::logger::instance().start(nullptr, std::move(file));
+		return true;
+	}
+
+	// Drains every buffer and stops the writer thread.
+	inline void stop()
+	{
+		detail::logger::instance().stop();
+	}
+
+	// Offline decoder: turns a binary log into "<steady-clock ticks> <message>" lines.
+	inline bool decode(std::istream& in, std::ostream& out)
+	{
+		char magic[7];
+		if (!in.read(magic, 7) || std::string_view(magic, 7) != "MCLOG1\n")
+		{
+			return false;
+		}
+		std::unordered_map<std::uint32_t, detail::site_info> sites;
+		std::vector<char> payload;
+		std::string line;
+		char kind;
+		while (in.get(kind))
+		{
+			std::uint32_t id;
+			in.read(reinterpret_cast<char*>(&id), 4);
+			if (kind == 'S')
+			{
+				std::uint32_t len, argc;
+				detail::site_info s;
+				in.read(reinterpret_cast<char*>(&len), 4);
+				s.fmt.resize(len);
+				in.read(&s.fmt[0], len);
+				in.read(reinterpret_cast<char*>(&argc), 4);
+				s.tags.resize(argc);
+				in.read(reinterpret_cast<char*>(s.tags.data()), argc);
+				sites[id] = std::move(s);
+			}
+			else if (kind == 'R')
+			{
+				std::uint64_t ts;
+				std::uint32_t n;
+				in.read(reinterpret_cast<char*>(&ts), 8);
+				in.read(reinterpret_cast<char*>(&n), 4);
+				payload.resize(n);
+				in.read(payload.data(), n);
+				auto it = sites.find(id);
+				if (!in || it == sites.end())
+				{
+					return false;
+				}
+				line = std::to_string(ts);
+				line += ' ';
+				detail::format(line, it->second.fmt, it->second.tags, payload.data());
+				line += '\n';
+				out << line;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+#define FASTLOG(fmt) ::fastlog::detail::make_call_site<::fastlog::count_placeholders(fmt)>([]() noexcept -> const char* { return fmt; })
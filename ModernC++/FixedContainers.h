@@ -0,0 +1,368 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+/*
+Fixed-capacity containers
+ring_buffer<T, N>, inline_vector<T, N> and bitset_set<N> keep all of their elements inside the object and never allocate, so pushing and popping costs the same on every call: no reallocation, no allocator lock, no page fault on a fresh block. Like MyContainer, they support class template argument deduction. The capacity is taken from the initializer, so ring_buffer r{ 1, 2, 3 } is a ring_buffer<int, 3>. Every member function is constexpr, so a whole container can be built and used at compile time.
+
+Storage is a plain array of N value-initialized elements (C++17 constant evaluation cannot start an object's lifetime in raw storage), so T must be default-constructible; these are meant for small, cheap element types.
+*/
+namespace fixed
+{
+	// FIFO of at most N elements. push_back fails when full; push_overwrite
+	// drops the oldest element instead.
+	template <typename T, std::size_t N>
+	class ring_buffer
+	{
+		static_assert(N > 0, "ring_buffer needs a non-zero capacity");
+
+		T data[N] = {};
+		std::size_t head = 0;
+		std::size_t count = 0;
+
+	public:
+		using value_type = T;
+
+		template <bool Const>
+		class basic_iterator
+		{
+			friend class ring_buffer;
+			using owner = std::conditional_t<Const, const ring_buffer, ring_buffer>;
+			owner* r;
+			std::size_t i;
+			constexpr basic_iterator(owner* r, std::size_t i) : r(r), i(i) {}
+
+		public:
+			using value_type = T;
+			using reference = std::conditional_t<Const, const T&, T&>;
+			using pointer = std::conditional_t<Const, const T*, T*>;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+
+			constexpr reference operator*() const { return (*r)[i]; }
+			constexpr basic_iterator& operator++()
+			{
+				++i;
+				return *this;
+			}
+			constexpr basic_iterator operator++(int)
+			{
+				auto tmp = *this;
+				++i;
+				return tmp;
+			}
+			constexpr bool operator==(const basic_iterator& o) const { return i == o.i; }
+			constexpr bool operator!=(const basic_iterator& o) const { return i != o.i; }
+		};
+
+		using iterator = basic_iterator<false>;
+		using const_iterator = basic_iterator<true>;
+
+		constexpr ring_buffer() = default;
+
+		template <typename... U, typename = std::enable_if_t<(sizeof...(U) > 0 && sizeof...(U) <= N
+			&& (!std::is_same<std::decay_t<U>, ring_buffer>::value && ...))>>
+		constexpr ring_buffer(U&&... values) : data{ T(std::forward<U>(values))... }, count(sizeof...(U)) {}
+
+		static constexpr std::size_t capacity() { return N; }
+		constexpr std::size_t size() const { return count; }
+		constexpr bool empty() const { return count == 0; }
+		constexpr bool full() const { return count == N; }
+
+		constexpr bool push_back(const T& v)
+		{
+			if (count == N)
+			{
+				return false;
+			}
+			data[(head + count) % N] = v;
+			++count;
+			return true;
+		}
+
+		constexpr void push_overwrite(const T& v)
+		{
+			if (count == N)
+			{
+				data[head] = v;
+				head = (head + 1) % N;
+			}
+			else
+			{
+				data[(head + count) % N] = v;
+				++count;
+			}
+		}
+
+		// Precondition: !empty().
+		constexpr T pop_front()
+		{
+			T v = std::move(data[head]);
+			head = (head + 1) % N;
+			--count;
+			return v;
+		}
+
+		constexpr T& front() { return data[head]; }
+		constexpr const T& front() const { return data[head]; }
+		constexpr T& back() { return data[(head + count - 1) % N]; }
+		constexpr const T& back() const { return data[(head + count - 1) % N]; }
+
+		// i-th element from the front.
+		constexpr T& operator[](std::size_t i) { return data[(head + i) % N]; }
+		constexpr const T& operator[](std::size_t i) const { return data[(head + i) % N]; }
+
+		constexpr void clear()
+		{
+			head = 0;
+			count = 0;
+		}
+
+		constexpr iterator begin() { return iterator(this, 0); }
+		constexpr iterator end() { return iterator(this, count); }
+		constexpr const_iterator begin() const { return const_iterator(this, 0); }
+		constexpr const_iterator end() const { return const_iterator(this, count); }
+	};
+
+	template <typename T, typename... U>
+	ring_buffer(T, U...) -> ring_buffer<T, 1 + sizeof...(U)>;
+
+	// Vector with the elements stored inline; growing past N throws length_error.
+	template <typename T, std::size_t N>
+	class inline_vector
+	{
+		T data_[N] = {};
+		std::size_t count = 0;
+
+	public:
+		using value_type = T;
+		using iterator = T*;
+		using const_iterator = const T*;
+
+		constexpr inline_vector() = default;
+
+		template <typename... U, typename = std::enable_if_t<(sizeof...(U) > 0 && sizeof...(U) <= N
+			&& (!std::is_same<std::decay_t<U>, inline_vector>::value && ...))>>
+		constexpr inline_vector(U&&... values) : data_{ T(std::forward<U>(values))... }, count(sizeof...(U)) {}
+
+		static constexpr std::size_t capacity() { return N; }
+		constexpr std::size_t size() const { return count; }
+		constexpr bool empty() const { return count == 0; }
+		constexpr bool full() const { return count == N; }
+
+		constexpr void push_back(const T& v)
+		{
+			if (count == N)
+			{
+				throw std::length_error("inline_vector capacity exceeded");
+			}
+			data_[count++] = v;
+		}
+
+		constexpr bool try_push_back(const T& v)
+		{
+			if (count == N)
+			{
+				return false;
+			}
+			data_[count++] = v;
+			return true;
+		}
+
+		constexpr void pop_back() { --count; }
+
+		// Overwrites the removed slot with the last element; does not keep order.
+		constexpr void swap_remove(std::size_t i)
+		{
+			data_[i] = std::move(data_[count - 1]);
+			--count;
+		}
+
+		constexpr void clear() { count = 0; }
+
+		constexpr T& operator[](std::size_t i) { return data_[i]; }
+		constexpr const T& operator[](std::size_t i) const { return data_[i]; }
+		constexpr T& back() { return data_[count - 1]; }
+		constexpr const T& back() const { return data_[count - 1]; }
+		constexpr T* data() { return data_; }
+		constexpr const T* data() const { return data_; }
+
+		constexpr iterator begin() { return data_; }
+		constexpr iterator end() { return data_ + count; }
+		constexpr const_iterator begin() const { return data_; }
+		constexpr const_iterator end() const { return data_ + count; }
+	};
+
+	template <typename T, typename... U>
+	inline_vector(T, U...) -> inline_vector<T, 1 + sizeof...(U)>;
+
+	// Set of integers in [0, N), one bit per possible member.
+	template <std::size_t N = 64>
+	class bitset_set
+	{
+		static constexpr std::size_t words = (N + 63) / 64;
+		std::uint64_t bits[words] = {};
+
+		static constexpr int popcount(std::uint64_t x)
+		{
+			int n = 0;
+			for (; x; x &= x - 1)
+			{
+				++n;
+			}
+			return n;
+		}
+
+	public:
+		using value_type = std::size_t;
+
+		class iterator
+		{
+			friend class bitset_set;
+			const bitset_set* s;
+			std::size_t i;
+			constexpr iterator(const bitset_set* s, std::size_t i) : s(s), i(i) {}
+			constexpr void skip()
+			{
+				while (i < N && !s->contains(i))
+				{
+					// Jump over empty words instead of testing 64 zero bits.
+					if (i % 64 == 0 && s->bits[i / 64] == 0)
+					{
+						i += 64;
+					}
+					else
+					{
+						++i;
+					}
+				}
+				if (i > N)
+				{
+					i = N;
+				}
+			}
+
+		public:
+			using value_type = std::size_t;
+			using reference = std::size_t;
+			using pointer = void;
+			using difference_type = std::ptrdiff_t;
+			using iterator_category = std::forward_iterator_tag;
+
+			constexpr std::size_t operator*() const { return i; }
+			constexpr iterator& operator++()
+			{
+				++i;
+				skip();
+				return *this;
+			}
+			constexpr bool operator==(const iterator& o) const { return i == o.i; }
+			constexpr bool operator!=(const iterator& o) const { return i != o.i; }
+		};
+
+		constexpr bitset_set() = default;
+		constexpr bitset_set(std::initializer_list<std::size_t> values)
+		{
+			for (std::size_t v : values)
+			{
+				insert(v);
+			}
+		}
+
+		static constexpr std::size_t capacity() { return N; }
+
+		// Returns false if v was already present. Precondition: v < N.
+		constexpr bool insert(std::size_t v)
+		{
+			const std::uint64_t mask = std::uint64_t(1) << (v % 64);
+			const bool added = (bits[v / 64] & mask) == 0;
+			bits[v / 64] |= mask;
+			return added;
+		}
+
+		constexpr bool erase(std::size_t v)
+		{
+			const std::uint64_t mask = std::uint64_t(1) << (v % 64);
+			const bool removed = (bits[v / 64] & mask) != 0;
+			bits[v / 64] &= ~mask;
+			return removed;
+		}
+
+		constexpr bool contains(std::size_t v) const
+		{
+			return v < N && (bits[v / 64] >> (v % 64) & 1) != 0;
+		}
+
+		constexpr std::size_t size() const
+		{
+			std::size_t n = 0;
+			for (std::size_t w = 0; w < words; ++w)
+			{
+				n += popcount(bits[w]);
+			}
+			return n;
+		}
+
+		constexpr bool empty() const
+		{
+			for (std::size_t w = 0; w < words; ++w)
+			{
+				if (bits[w])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+
+		constexpr void clear()
+		{
+			for (std::size_t w = 0; w < words; ++w)
+			{
+				bits[w] = 0;
+			}
+		}
+
+		constexpr bitset_set& operator|=(const bitset_set& o)
+		{
+			for (std::size_t w = 0; w < words; ++w) bits[w] |= o.bits[w];
+			return *this;
+		}
+
+		constexpr bitset_set& operator&=(const bitset_set& o)
+		{
+			for (std::size_t w = 0; w < words; ++w) bits[w] &= o.bits[w];
+			return *this;
+		}
+
+		friend constexpr bitset_set operator|(bitset_set a, const bitset_set& b) { return a |= b; }
+		friend constexpr bitset_set operator&(bitset_set a, const bitset_set& b) { return a &= b; }
+
+		friend constexpr bool operator==(const bitset_set& a, const bitset_set& b)
+		{
+			for (std::size_t w = 0; w < words; ++w)
+			{
+				if (a.bits[w] != b.bits[w])
+				{
+					return false;
+				}
+			}
+			return true;
+		}
+		friend constexpr bool operator!=(const bitset_set& a, const bitset_set& b) { return !(a == b); }
+
+		constexpr iterator begin() const
+		{
+			iterator it(this, 0);
+			it.skip();
+			return it;
+		}
+		constexpr iterator end() const { return iterator(this, N); }
+	};
+}
@@ -0,0 +1,738 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FLATHASH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+Swiss-table hash containers
+flat_hash_map and flat_hash_set are open-addressing tables in the style of Abseil's Swiss tables. Every slot has a one-byte control tag holding 7 bits of its hash; a lookup loads the tags of a 16-slot group at once and compares them with SSE2, so most misses and hits touch a single group and compare at most one key.
+
+The default hashes are tuned for the project's key types: integers and strings. String hashes are transparent, so a map keyed by std::string can be searched with a std::string_view or a literal without building a temporary std::string. extract()/insert(node) mirror the node-handle interface of std::map used in the splicing demo. Because slots are stored inline, a node owns a moved-out copy of the element instead of an allocation.
+*/
+namespace flathash
+{
+	inline std::uint64_t mix(std::uint64_t h)
+	{
+		// MurmurHash3 fmix64: every input bit affects every output bit.
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	inline std::uint64_t hash_bytes(const char* p, std::size_t n)
+	{
+		std::uint64_t h = 0x9e3779b97f4a7c15ull ^ (n * 0xc2b2ae3d27d4eb4full);
+		for (; n >= 8; p += 8, n -= 8)
+		{
+			std::uint64_t chunk;
+			std::memcpy(&chunk, p, 8);
+			h = (h ^ mix(chunk)) * 0x9e3779b97f4a7c15ull;
+		}
+		if (n > 0)
+		{
+			std::uint64_t chunk = 0;
+			std::memcpy(&chunk, p, n);
+			h = (h ^ mix(chunk)) * 0x9e3779b97f4a7c15ull;
+		}
+		return mix(h);
+	}
+
+	template <typename T, typename = void>
+	struct hash : std::hash<T>
+	{
+		std::uint64_t operator()(const T& v) const { return mix(std::hash<T>::operator()(v)); }
+	};
+
+	// One 64x64->128 multiply, folded; cheaper than mix() and good enough for integer keys.
+	inline std::uint64_t mix_int(std::uint64_t v)
+	{
+		constexpr std::uint64_t k = 0x9e3779b97f4a7c15ull;
+#if defined(_MSC_VER) && defined(_M_X64)
+		std::uint64_t hi;
+		const std::uint64_t lo = _umul128(v, k, &hi);
+		return lo ^ hi;
+#elif defined(__SIZEOF_INT128__)
+		const unsigned __int128 p = static_cast<unsigned __int128>(v) * k;
+		return static_cast<std::uint64_t>(p) ^ static_cast<std::uint64_t>(p >> 64);
+#else
+		return mix(v);
+#endif
+	}
+
+	template <typename T>
+	struct hash<T, std::enable_if_t<std::is_integral<T>::value || std::is_enum<T>::value>>
+	{
+		std::uint64_t operator()(T v) const { return mix_int(static_cast<std::uint64_t>(v)); }
+	};
+
+	struct string_hash
+	{
+		using is_transparent = void;
+		std::uint64_t operator()(std::string_view s) const { return hash_bytes(s.data(), s.size()); }
+	};
+
+	template <>
+	struct hash<std::string> : string_hash {};
+
+	template <>
+	struct hash<std::string_view> : string_hash {};
+
+	template <typename T>
+	struct equal_to : std::equal_to<T> {};
+
+	template <>
+	struct equal_to<std::string> : std::equal_to<>
+	{
+		using is_transparent = void;
+	};
+
+	template <>
+	struct equal_to<std::string_view> : std::equal_to<>
+	{
+		using is_transparent = void;
+	};
+
+	namespace detail
+	{
+		using ctrl_t = std::int8_t;
+		constexpr ctrl_t ctrl_empty = -128;  // 0b10000000
+		constexpr ctrl_t ctrl_deleted = -2;  // 0b11111110
+		constexpr std::size_t group_width = 16;
+
+		// Bit i set <=> slot i of the group matches.
+		class bitmask
+		{
+			std::uint32_t bits;
+
+		public:
+			explicit bitmask(std::uint32_t b) : bits(b) {}
+			explicit operator bool() const { return bits != 0; }
+			int lowest() const
+			{
+#if defined(_MSC_VER)
+				unsigned long i;
+				_BitScanForward(&i, bits);
+				return static_cast<int>(i);
+#else
+				return __builtin_ctz(bits);
+#endif
+			}
+			void clear_lowest() { bits &= bits - 1; }
+		};
+
+		struct group
+		{
+#if defined(FLATHASH_SSE2)
+			__m128i ctrl;
+			explicit group(const ctrl_t* p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+
+			bitmask match(ctrl_t h2) const
+			{
+				return bitmask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))));
+			}
+			bitmask match_empty() const { return match(ctrl_empty); }
+			bitmask match_free() const
+			{
+				// ctrl_empty and ctrl_deleted are the only negative tags below -1
+				return bitmask(static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), ctrl))));
+			}
+#else
+			const ctrl_t* ctrl;
+			explicit group(const ctrl_t* p) : ctrl(p) {}
+
+			bitmask match(ctrl_t h2) const
+			{
+				std::uint32_t m = 0;
+				for (std::size_t i = 0; i < group_width; ++i) m |= std::uint32_t(ctrl[i] == h2) << i;
+				return bitmask(m);
+			}
+			bitmask match_empty() const { return match(ctrl_empty); }
+			bitmask match_free() const
+			{
+				std::uint32_t m = 0;
+				for (std::size_t i = 0; i < group_width; ++i) m |= std::uint32_t(ctrl[i] < -1) << i;
+				return bitmask(m);
+			}
+#endif
+		};
+
+		template <typename H, typename E, typename = void>
+		struct is_transparent : std::false_type {};
+
+		template <typename H, typename E>
+		struct is_transparent<H, E, std::void_t<typename H::is_transparent, typename E::is_transparent>> : std::true_type {};
+
+		// The open-addressing table behind both containers. Policy describes the
+		// slot type and how to get a key out of it.
+		template <typename Policy, typename Hash, typename Eq>
+		class raw_table
+		{
+		public:
+			using key_type = typename Policy::key_type;
+			using slot_type = typename Policy::slot_type;
+
+			template <bool Const>
+			class basic_iterator
+			{
+				friend class raw_table;
+				template <bool> friend class basic_iterator;
+				const ctrl_t* ctrl = nullptr;
+				slot_type* slot = nullptr;
+				const ctrl_t* end = nullptr;
+
+				basic_iterator(const ctrl_t* c, slot_type* s, const ctrl_t* e) : ctrl(c), slot(s), end(e) { skip(); }
+				void skip()
+				{
+					while (ctrl != end && *ctrl < 0)
+					{
+						++ctrl;
+						++slot;
+					}
+				}
+
+			public:
+				using value_type = typename Policy::value_type;
+				using reference = std::conditional_t<Const, const value_type&, value_type&>;
+				using pointer = std::conditional_t<Const, const value_type*, value_type*>;
+				using difference_type = std::ptrdiff_t;
+				using iterator_category = std::forward_iterator_tag;
+
+				basic_iterator() = default;
+				template <bool C = Const, typename = std::enable_if_t<C>>
+				basic_iterator(const basic_iterator<false>& o) : ctrl(o.ctrl), slot(o.slot), end(o.end) {}
+
+				reference operator*() const { return Policy::element(*slot); }
+				pointer operator->() const { return &Policy::element(*slot); }
+				basic_iterator& operator++()
+				{
+					++ctrl;
+					++slot;
+					skip();
+					return *this;
+				}
+				basic_iterator operator++(int)
+				{
+					auto tmp = *this;
+					++*this;
+					return tmp;
+				}
+				friend bool operator==(const basic_iterator& a, const basic_iterator& b) { return a.ctrl == b.ctrl; }
+				friend bool operator!=(const basic_iterator& a, const basic_iterator& b) { return a.ctrl != b.ctrl; }
+			};
+
+			using iterator = basic_iterator<false>;
+			using const_iterator = basic_iterator<true>;
+
+			raw_table() = default;
+
+			raw_table(const raw_table& o) : hasher(o.hasher), eq(o.eq)
+			{
+				reserve(o.count);
+				for (const auto& v : o)
+				{
+					emplace_unique(Policy::key(v), v);
+				}
+			}
+
+			raw_table(raw_table&& o) noexcept
+				: ctrl(o.ctrl), slots(o.slots), capacity(o.capacity), count(o.count), growth_left(o.growth_left),
+				hasher(std::move(o.hasher)), eq(std::move(o.eq))
+			{
+				o.ctrl = nullptr;
+				o.slots = nullptr;
+				o.capacity = o.count = o.growth_left = 0;
+			}
+
+			raw_table& operator=(raw_table o) noexcept
+			{
+				swap(o);
+				return *this;
+			}
+
+			~raw_table() { destroy(); }
+
+			void swap(raw_table& o) noexcept
+			{
+				std::swap(ctrl, o.ctrl);
+				std::swap(slots, o.slots);
+				std::swap(capacity, o.capacity);
+				std::swap(count, o.count);
+				std::swap(growth_left, o.growth_left);
+				std::swap(hasher, o.hasher);
+				std::swap(eq, o.eq);
+			}
+
+			iterator begin() { return iterator(ctrl, slots, ctrl + capacity); }
+			iterator end() { return iterator(ctrl + capacity, slots + capacity, ctrl + capacity); }
+			const_iterator begin() const { return const_cast<raw_table*>(this)->begin(); }
+			const_iterator end() const { return const_cast<raw_table*>(this)->end(); }
+
+			std::size_t size() const { return count; }
+			bool empty() const { return count == 0; }
+			std::size_t bucket_count() const { return capacity; }
+
+			void clear()
+			{
+				destroy();
+				ctrl = nullptr;
+				slots = nullptr;
+				capacity = count = growth_left = 0;
+			}
+
+			void reserve(std::size_t n)
+			{
+				if (n > count + growth_left)
+				{
+					std::size_t cap = group_width;
+					while (cap - cap / 8 < n) cap *= 2;
+					resize(cap);
+				}
+			}
+
+			template <typename K>
+			iterator find(const K& key)
+			{
+				if (capacity == 0)
+				{
+					return end();
+				}
+				const std::uint64_t h = hasher(key);
+				const ctrl_t h2 = static_cast<ctrl_t>(h & 0x7f);
+				const std::size_t mask = capacity / group_width - 1;
+				std::size_t g = (h >> 7) & mask;
+				for (std::size_t step = 1;; ++step)
+				{
+					const std::size_t base = g * group_width;
+					group grp(ctrl + base);
+					for (bitmask m = grp.match(h2); m; m.clear_lowest())
+					{
+						const std::size_t i = base + m.lowest();
+						if (eq(Policy::key(Policy::element(slots[i])), key))
+						{
+							return iterator(ctrl + i, slots + i, ctrl + capacity);
+						}
+					}
+					if (grp.match_empty())
+					{
+						return end();
+					}
+					g = (g + step) & mask; // triangular probing visits every group
+				}
+			}
+
+			template <typename K>
+			const_iterator find(const K& key) const { return const_cast<raw_table*>(this)->find(key); }
+
+			// Inserts Policy-constructed element for `key` unless it is already present.
+			template <typename K, typename... Args>
+			std::pair<iterator, bool> emplace_unique(const K& key, Args&&... args)
+			{
+				auto it = find(key);
+				if (it != end())
+				{
+					return { it, false };
+				}
+				const std::uint64_t h = hasher(key);
+				if (capacity == 0)
+				{
+					resize(group_width);
+				}
+				std::size_t i = find_free(h);
+				if (growth_left == 0 && ctrl[i] == ctrl_empty)
+				{
+					// Out of empty slots: grow, or just drop tombstones if they are most of the load.
+					resize(count * 2 > capacity - capacity / 8 ? capacity * 2 : capacity);
+					i = find_free(h);
+				}
+				::new (static_cast<void*>(slots + i)) slot_type(std::forward<Args>(args)...);
+				growth_left -= ctrl[i] == ctrl_empty;
+				ctrl[i] = static_cast<ctrl_t>(h & 0x7f);
+				++count;
+				return { iterator(ctrl + i, slots + i, ctrl + capacity), true };
+			}
+
+			iterator erase(iterator it)
+			{
+				const std::size_t i = static_cast<std::size_t>(it.ctrl - ctrl);
+				slots[i].~slot_type();
+				--count;
+				// A group that still has an empty slot was never full, so no probe
+				// sequence continues past it and the slot can become empty again.
+				if (group(ctrl + i / group_width * group_width).match_empty())
+				{
+					ctrl[i] = ctrl_empty;
+					++growth_left;
+				}
+				else
+				{
+					ctrl[i] = ctrl_deleted;
+				}
+				++it;
+				return it;
+			}
+
+			template <typename K>
+			std::size_t erase_key(const K& key)
+			{
+				auto it = find(key);
+				if (it == end())
+				{
+					return 0;
+				}
+				erase(it);
+				return 1;
+			}
+
+			// Moves the element out and erases its slot.
+			typename Policy::node_value take(iterator it)
+			{
+				typename Policy::node_value v = Policy::take(*it.slot);
+				erase(it);
+				return v;
+			}
+
+		private:
+			std::size_t find_free(std::uint64_t h) const
+			{
+				const std::size_t mask = capacity / group_width - 1;
+				std::size_t g = (h >> 7) & mask;
+				for (std::size_t step = 1;; ++step)
+				{
+					group grp(ctrl + g * group_width);
+					if (bitmask m = grp.match_free())
+					{
+						return g * group_width + m.lowest();
+					}
+					g = (g + step) & mask;
+				}
+			}
+
+			void resize(std::size_t new_capacity)
+			{
+				ctrl_t* old_ctrl = ctrl;
+				slot_type* old_slots = slots;
+				const std::size_t old_capacity = capacity;
+
+				ctrl = static_cast<ctrl_t*>(::operator new(new_capacity));
+				std::memset(ctrl, static_cast<unsigned char>(ctrl_empty), new_capacity);
+				slots = std::allocator<slot_type>().allocate(new_capacity);
+				capacity = new_capacity;
+				growth_left = capacity - capacity / 8 - count;
+
+				for (std::size_t i = 0; i < old_capacity; ++i)
+				{
+					if (old_ctrl[i] >= 0)
+					{
+						const std::uint64_t h = hasher(Policy::key(Policy::element(old_slots[i])));
+						const std::size_t j = find_free(h);
+						::new (static_cast<void*>(slots + j)) slot_type(std::move(old_slots[i]));
+						ctrl[j] = static_cast<ctrl_t>(h & 0x7f);
+						old_slots[i].~slot_type();
+					}
+				}
+				if (old_ctrl)
+				{
+					::operator delete(old_ctrl);
+					std::allocator<slot_type>().deallocate(old_slots, old_capacity);
+				}
+			}
+
+			void destroy()
+			{
+				if (!ctrl)
+				{
+					return;
+				}
+				for (std::size_t i = 0; i < capacity; ++i)
+				{
+					if (ctrl[i] >= 0)
+					{
+						slots[i].~slot_type();
+					}
+				}
+				::operator delete(ctrl);
+				std::allocator<slot_type>().deallocate(slots, capacity);
+			}
+
+			ctrl_t* ctrl = nullptr;
+			slot_type* slots = nullptr;
+			std::size_t capacity = 0;
+			std::size_t count = 0;
+			std::size_t growth_left = 0;
+			Hash hasher;
+			Eq eq;
+		};
+
+		template <typename K, typename V>
+		struct map_policy
+		{
+			using key_type = K;
+			using value_type = std::pair<const K, V>;
+			using slot_type = value_type;
+			using node_value = std::pair<K, V>;
+
+			static value_type& element(slot_type& s) { return s; }
+			static const K& key(const value_type& v) { return v.first; }
+			// The key is const inside the table, so it is copied; the value is moved.
+			static node_value take(slot_type& s) { return node_value(s.first, std::move(s.second)); }
+		};
+
+		template <typename K>
+		struct set_policy
+		{
+			using key_type = K;
+			using value_type = const K;
+			using slot_type = K;
+			using node_value = K;
+
+			static const K& element(const slot_type& s) { return s; }
+			static const K& key(const K& v) { return v; }
+			static node_value take(slot_type& s) { return std::move(s); }
+		};
+	}
+
+	// Detached element returned by extract(); re-inserted with insert(std::move(node)).
+	template <typename K, typename V>
+	class map_node
+	{
+		template <typename, typename, typename, typename> friend class flat_hash_map;
+		std::optional<std::pair<K, V>> v;
+
+	public:
+		map_node() = default;
+		explicit map_node(std::pair<K, V>&& p) : v(std::move(p)) {}
+		bool empty() const { return !v; }
+		explicit operator bool() const { return v.has_value(); }
+		K& key() { return v->first; }
+		V& mapped() { return v->second; }
+	};
+
+	template <typename K>
+	class set_node
+	{
+		template <typename, typename, typename> friend class flat_hash_set;
+		std::optional<K> v;
+
+	public:
+		set_node() = default;
+		explicit set_node(K&& k) : v(std::move(k)) {}
+		bool empty() const { return !v; }
+		explicit operator bool() const { return v.has_value(); }
+		K& value() { return *v; }
+	};
+
+	template <typename K, typename V, typename Hash = hash<K>, typename Eq = equal_to<K>>
+	class flat_hash_map
+	{
+		using table = detail::raw_table<detail::map_policy<K, V>, Hash, Eq>;
+		table t;
+
+		// Heterogeneous lookup is only offered when both Hash and Eq opt in.
+		template <typename Q>
+		using lookup_key = std::conditional_t<detail::is_transparent<Hash, Eq>::value, Q, K>;
+
+	public:
+		using key_type = K;
+		using mapped_type = V;
+		using value_type = std::pair<const K, V>;
+		using iterator = typename table::iterator;
+		using const_iterator = typename table::const_iterator;
+		using node_type = map_node<K, V>;
+
+		flat_hash_map() = default;
+		flat_hash_map(std::initializer_list<value_type> init)
+		{
+			t.reserve(init.size());
+			for (const auto& v : init) insert(v);
+		}
+
+		iterator begin() { return t.begin(); }
+		iterator end() { return t.end(); }
+		const_iterator begin() const { return t.begin(); }
+		const_iterator end() const { return t.end(); }
+		std::size_t size() const { return t.size(); }
+		bool empty() const { return t.empty(); }
+		void clear() { t.clear(); }
+		void reserve(std::size_t n) { t.reserve(n); }
+
+		template <typename Q = K>
+		iterator find(const Q& key) { return t.find(static_cast<const lookup_key<Q>&>(key)); }
+		template <typename Q = K>
+		const_iterator find(const Q& key) const { return t.find(static_cast<const lookup_key<Q>&>(key)); }
+		template <typename Q = K>
+		bool contains(const Q& key) const { return find(key) != end(); }
+		template <typename Q = K>
+		std::size_t count(const Q& key) const { return contains(key) ? 1 : 0; }
+
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+		{
+			return t.emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(key),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		template <typename... Args>
+		std::pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+		{
+			return t.emplace_unique(key, std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		}
+
+		std::pair<iterator, bool> insert(const value_type& v) { return t.emplace_unique(v.first, v); }
+		std::pair<iterator, bool> insert(std::pair<K, V>&& v) { return try_emplace(std::move(v.first), std::move(v.second)); }
+
+		template <typename M>
+		std::pair<iterator, bool> insert_or_assign(const K& key, M&& m)
+		{
+			auto r = try_emplace(key, std::forward<M>(m));
+			if (!r.second) r.first->second = std::forward<M>(m);
+			return r;
+		}
+
+		V& operator[](const K& key) { return try_emplace(key).first->second; }
+		V& operator[](K&& key) { return try_emplace(std::move(key)).first->second; }
+
+		template <typename Q = K>
+		V& at(const Q& key)
+		{
+			auto it = find(key);
+			if (it == end()) throw std::out_of_range("flat_hash_map::at");
+			return it->second;
+		}
+
+		iterator erase(iterator it) { return t.erase(it); }
+		template <typename Q = K>
+		std::size_t erase(const Q& key) { return t.erase_key(static_cast<const lookup_key<Q>&>(key)); }
+
+		node_type extract(iterator it) { return node_type(t.take(it)); }
+		template <typename Q = K>
+		node_type extract(const Q& key)
+		{
+			auto it = find(key);
+			return it == end() ? node_type() : extract(it);
+		}
+
+		struct insert_return_type
+		{
+			iterator position;
+			bool inserted;
+			node_type node;
+		};
+
+		// Like std::map::insert(node_type&&): on a key collision the node is handed back.
+		insert_return_type insert(node_type&& node)
+		{
+			if (node.empty())
+			{
+				return { end(), false, node_type() };
+			}
+			auto it = find(node.key());
+			if (it != end())
+			{
+				return { it, false, std::move(node) };
+			}
+			auto r = insert(std::move(*node.v));
+			node.v.reset();
+			return { r.first, true, node_type() };
+		}
+	};
+
+	template <typename K, typename Hash = hash<K>, typename Eq = equal_to<K>>
+	class flat_hash_set
+	{
+		using table = detail::raw_table<detail::set_policy<K>, Hash, Eq>;
+		table t;
+
+		template <typename Q>
+		using lookup_key = std::conditional_t<detail::is_transparent<Hash, Eq>::value, Q, K>;
+
+	public:
+		using key_type = K;
+		using value_type = K;
+		using iterator = typename table::const_iterator;
+		using const_iterator = typename table::const_iterator;
+		using node_type = set_node<K>;
+
+		flat_hash_set() = default;
+		flat_hash_set(std::initializer_list<K> init)
+		{
+			t.reserve(init.size());
+			for (const auto& k : init) insert(k);
+		}
+
+		const_iterator begin() const { return t.begin(); }
+		const_iterator end() const { return t.end(); }
+		std::size_t size() const { return t.size(); }
+		bool empty() const { return t.empty(); }
+		void clear() { t.clear(); }
+		void reserve(std::size_t n) { t.reserve(n); }
+
+		template <typename Q = K>
+		const_iterator find(const Q& key) const { return t.find(static_cast<const lookup_key<Q>&>(key)); }
+		template <typename Q = K>
+		bool contains(const Q& key) const { return find(key) != end(); }
+		template <typename Q = K>
+		std::size_t count(const Q& key) const { return contains(key) ? 1 : 0; }
+
+		std::pair<const_iterator, bool> insert(const K& k) { return t.emplace_unique(k, k); }
+		std::pair<const_iterator, bool> insert(K&& k) { return t.emplace_unique(k, std::move(k)); }
+
+		template <typename Q = K>
+		std::size_t erase(const Q& key) { return t.erase_key(static_cast<const lookup_key<Q>&>(key)); }
+
+		template <typename Q = K>
+		node_type extract(const Q& key)
+		{
+			auto it = t.find(static_cast<const lookup_key<Q>&>(key));
+			return it == t.end() ? node_type() : node_type(t.take(it));
+		}
+
+		std::pair<const_iterator, bool> insert(node_type&& node)
+		{
+			if (node.empty())
+			{
+				return { end(), false };
+			}
+			auto r = insert(std::move(*node.v));
+			if (r.second) node.v.reset();
+			return r;
+		}
+
+		// Moves every element of `src` that is not already present, like std::set::merge.
+		void merge(flat_hash_set& src)
+		{
+			for (auto it = src.t.begin(); it != src.t.end();)
+			{
+				if (!contains(*it))
+				{
+					insert(src.t.take(it++));
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+	};
+}
@@ -0,0 +1,680 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "Queues.h"
+
+/*
+Futures with continuations
+fut::promise<T>/fut::future<T> work like std::promise/std::future, with two differences. First, the shared state comes from a per-thread slab of fixed-size blocks instead of a fresh heap allocation for every pair. Second, a future can be chained with then(executor, fn): fn runs on the executor as soon as the value is set, and its result feeds the next future. No thread has to block in get() between stages.
+
+The continuation is stored inline in the shared state when it fits in 48 bytes, so a hop of a pipeline costs no heap allocation once the slab is warm. Executors passed to then() are held by reference and must outlive the chain. when_all/when_any combine several futures. inline_executor runs continuations on the thread that completes the value; thread_pool runs them on worker threads, or on the calling thread once the pool is shutting down.
+*/
+namespace fut
+{
+	namespace detail
+	{
+		// Move-only void() callable with inline storage for small captures.
+		class task
+		{
+			static constexpr std::size_t inline_size = 48;
+
+			struct ops
+			{
+				void (*call)(void*);
+				void (*move)(void* from, void* to);
+				void (*destroy)(void*);
+			};
+
+			template <typename F>
+			static const ops* ops_for()
+			{
+				static const ops o = {
+					[](void* p) { (*static_cast<F*>(p))(); },
+					[](void* from, void* to) { ::new (to) F(std::move(*static_cast<F*>(from))); static_cast<F*>(from)->~F(); },
+					[](void* p) { static_cast<F*>(p)->~F(); },
+				};
+				return &o;
+			}
+
+			template <typename F>
+			struct boxed
+			{
+				std::unique_ptr<F> f;
+				void operator()() { (*f)(); }
+			};
+
+			alignas(std::max_align_t) unsigned char buf[inline_size];
+			const ops* vt = nullptr;
+
+		public:
+			task() = default;
+
+			template <typename F, typename = std::enable_if_t<!std::is_same<std::decay_t<F>, task>::value>>
+			task(F&& f)
+			{
+				using Fn = std::decay_t<F>;
+				if constexpr (sizeof(Fn) <= inline_size && alignof(Fn) <= alignof(std::max_align_t)
+					&& std::is_nothrow_move_constructible<Fn>::value)
+				{
+					::new (static_cast<void*>(buf)) Fn(std::forward<F>(f));
+					vt = ops_for<Fn>();
+				}
+				else
+				{
+					::new (static_cast<void*>(buf)) boxed<Fn>{ std::make_unique<Fn>(std::forward<F>(f)) };
+					vt = ops_for<boxed<Fn>>();
+				}
+			}
+
+			task(task&& o) noexcept : vt(o.vt)
+			{
+				if (vt)
+				{
+					vt->move(o.buf, buf);
+					o.vt = nullptr;
+				}
+			}
+
+			task& operator=(task&& o) noexcept
+			{
+				if (this != &o)
+				{
+					reset();
+					if (o.vt)
+					{
+						o.vt->move(o.buf, buf);
+						vt = o.vt;
+						o.vt = nullptr;
+					}
+				}
+				return *this;
+			}
+
+			~task() { reset(); }
+
+			explicit operator bool() const { return vt != nullptr; }
+			void operator()() { vt->call(buf); }
+
+			void reset()
+			{
+				if (vt)
+				{
+					vt->destroy(buf);
+					vt = nullptr;
+				}
+			}
+		};
+
+		// Per-thread free lists of fixed-size blocks, carved from 64-block chunks.
+		// A thread that frees more than it allocates (a pool worker releasing
+		// states made by the producer) hands whole batches to a shared list, so
+		// the allocating thread gets them back instead of growing new chunks.
+		template <std::size_t Size>
+		class slab
+		{
+			static constexpr std::size_t batch = 64;
+
+			union block
+			{
+				block* next;
+				alignas(std::max_align_t) unsigned char bytes[Size];
+			};
+
+			struct local
+			{
+				block* free = nullptr;
+				std::size_t count = 0;
+
+				// A thread that exits hands its blocks to the shared list.
+				~local()
+				{
+					if (free)
+					{
+						shared& g = global();
+						std::lock_guard<std::mutex> lk(g.m);
+						g.batches.emplace_back(free, count);
+					}
+				}
+			};
+
+			struct shared
+			{
+				std::mutex m;
+				std::vector<std::pair<block*, std::size_t>> batches; // list head, length
+			};
+
+			static local& list()
+			{
+				thread_local local l;
+				return l;
+			}
+
+			static shared& global()
+			{
+				static shared g;
+				return g;
+			}
+
+		public:
+			// Number of times the slab had to go to operator new.
+			static std::atomic<std::size_t>& chunk_allocations()
+			{
+				static std::atomic<std::size_t> n{ 0 };
+				return n;
+			}
+
+			static void* allocate()
+			{
+				local& l = list();
+				if (!l.free)
+				{
+					shared& g = global();
+					{
+						std::lock_guard<std::mutex> lk(g.m);
+						if (!g.batches.empty())
+						{
+							l.free = g.batches.back().first;
+							l.count = g.batches.back().second;
+							g.batches.pop_back();
+						}
+					}
+					if (!l.free)
+					{
+						auto* chunk = static_cast<block*>(::operator new(sizeof(block) * batch));
+						chunk_allocations().fetch_add(1, std::memory_order_relaxed);
+						for (std::size_t i = 0; i < batch; ++i)
+						{
+							chunk[i].next = i + 1 < batch ? &chunk[i + 1] : nullptr;
+						}
+						l.free = chunk;
+						l.count = batch;
+					}
+				}
+				block* b = l.free;
+				l.free = b->next;
+				--l.count;
+				return b;
+			}
+
+			static void deallocate(void* p)
+			{
+				local& l = list();
+				auto* b = static_cast<block*>(p);
+				b->next = l.free;
+				l.free = b;
+				if (++l.count == 2 * batch)
+				{
+					block* first = l.free;
+					block* last = first;
+					for (std::size_t i = 1; i < batch; ++i)
+					{
+						last = last->next;
+					}
+					l.free = last->next;
+					last->next = nullptr;
+					l.count -= batch;
+					shared& g = global();
+					std::lock_guard<std::mutex> lk(g.m);
+					g.batches.emplace_back(first, batch);
+				}
+			}
+		};
+
+		enum : std::uint32_t
+		{
+			has_value = 1,
+			has_continuation = 2,
+			has_waiter = 4,
+		};
+
+		template <typename T>
+		using stored_t = std::conditional_t<std::is_void<T>::value, std::monostate, T>;
+
+		template <typename T>
+		class state
+		{
+		public:
+			static state* create()
+			{
+				return ::new (slab<sizeof(state)>::allocate()) state();
+			}
+
+			void add_ref() { refs.fetch_add(1, std::memory_order_relaxed); }
+			void release()
+			{
+				if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					this->~state();
+					slab<sizeof(state)>::deallocate(this);
+				}
+			}
+
+			template <typename... Args>
+			void set_value(Args&&... args)
+			{
+				result.template emplace<1>(std::forward<Args>(args)...);
+				complete();
+			}
+
+			void set_exception(std::exception_ptr e)
+			{
+				result.template emplace<2>(std::move(e));
+				complete();
+			}
+
+			// Exactly one of complete() and attach() sees both bits and runs the continuation.
+			void attach(task cont)
+			{
+				continuation = std::move(cont);
+				if (phase.fetch_or(has_continuation, std::memory_order_acq_rel) & has_value)
+				{
+					run_continuation();
+				}
+			}
+
+			bool ready() const { return (phase.load(std::memory_order_acquire) & has_value) != 0; }
+
+			void wait()
+			{
+				for (int spin = 0; !ready(); ++spin)
+				{
+					if (spin < 64)
+					{
+						std::this_thread::yield();
+						continue;
+					}
+					const std::uint32_t p = phase.fetch_or(has_waiter, std::memory_order_acq_rel) | has_waiter;
+					if (!(p & has_value))
+					{
+						queues::detail::wait(phase, p);
+					}
+				}
+			}
+
+			// Moves the value out, or rethrows the stored exception.
+			stored_t<T> take()
+			{
+				if (result.index() == 2)
+				{
+					std::rethrow_exception(std::get<2>(result));
+				}
+				return std::move(std::get<1>(result));
+			}
+
+			bool has_exception() const { return result.index() == 2; }
+			std::exception_ptr exception() const { return std::get<2>(result); }
+
+		private:
+			state() = default;
+
+			void complete()
+			{
+				const std::uint32_t old = phase.fetch_or(has_value, std::memory_order_acq_rel);
+				if (old & has_waiter)
+				{
+					queues::detail::wake_all(phase);
+				}
+				if (old & has_continuation)
+				{
+					run_continuation();
+				}
+			}
+
+			void run_continuation()
+			{
+				task t = std::move(continuation);
+				t();
+			}
+
+			std::atomic<std::uint32_t> phase{ 0 };
+			std::atomic<std::uint32_t> refs{ 1 }; // the promise; get_future() adds one
+			std::variant<std::monostate, stored_t<T>, std::exception_ptr> result;
+			task continuation;
+		};
+
+	}
+
+	struct inline_executor
+	{
+		template <typename F>
+		void execute(F&& f) const { std::forward<F>(f)(); }
+	};
+
+	// Fixed set of worker threads draining a shared MPMC queue.
+	class thread_pool
+	{
+	public:
+		explicit thread_pool(unsigned threads = std::thread::hardware_concurrency(), std::size_t capacity = 1 << 16)
+			: tasks(capacity)
+		{
+			for (unsigned i = 0; i < (threads ? threads : 1); ++i)
+			{
+				workers.emplace_back([this] {
+					detail::task t;
+					while (tasks.pop(t))
+					{
+						t();
+						t.reset();
+					}
+				});
+			}
+		}
+
+		~thread_pool()
+		{
+			tasks.close();
+			for (auto& w : workers)
+			{
+				w.join();
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		// Once the pool is closing, runs f on the calling thread instead, so a
+		// continuation scheduled during shutdown still completes its future.
+		template <typename F>
+		void execute(F&& f)
+		{
+			detail::task t(std::forward<F>(f));
+			if (!tasks.push(std::move(t)))
+			{
+				t();
+			}
+		}
+
+	private:
+		queues::blocking_queue<queues::mpmc_queue<detail::task>> tasks;
+		std::vector<std::thread> workers;
+	};
+
+	template <typename T>
+	class future;
+
+	template <typename T>
+	class promise
+	{
+		detail::state<T>* s;
+
+	public:
+		promise() : s(detail::state<T>::create()) {}
+		promise(promise&& o) noexcept : s(std::exchange(o.s, nullptr)) {}
+		promise& operator=(promise&& o) noexcept
+		{
+			std::swap(s, o.s);
+			return *this;
+		}
+		// Like std::promise, abandoning an unsatisfied promise stores broken_promise.
+		~promise()
+		{
+			if (s)
+			{
+				if (!s->ready())
+				{
+					s->set_exception(std::make_exception_ptr(std::future_error(std::future_errc::broken_promise)));
+				}
+				s->release();
+			}
+		}
+
+		// Call at most once.
+		future<T> get_future()
+		{
+			s->add_ref();
+			return future<T>(s);
+		}
+
+		template <typename... Args>
+		void set_value(Args&&... args) { s->set_value(std::forward<Args>(args)...); }
+		void set_exception(std::exception_ptr e) { s->set_exception(std::move(e)); }
+	};
+
+	template <typename T>
+	class future
+	{
+		template <typename> friend class promise;
+		template <typename> friend class future;
+		detail::state<T>* s = nullptr;
+
+		explicit future(detail::state<T>* st) : s(st) {}
+
+	public:
+		using value_type = T;
+
+		future() = default;
+		future(future&& o) noexcept : s(std::exchange(o.s, nullptr)) {}
+		future& operator=(future&& o) noexcept
+		{
+			std::swap(s, o.s);
+			return *this;
+		}
+		~future()
+		{
+			if (s) s->release();
+		}
+
+		bool valid() const { return s != nullptr; }
+		bool ready() const { return s->ready(); }
+		void wait() const { s->wait(); }
+
+		// Blocks until the value is set; rethrows a stored exception. Call once.
+		T get()
+		{
+			s->wait();
+			if constexpr (std::is_void<T>::value)
+			{
+				s->take();
+			}
+			else
+			{
+				return s->take();
+			}
+		}
+
+		// Consumes this future. Once it is ready, runs fn(ready_future) on `ex`,
+		// which must outlive the call.
+		template <typename Executor, typename F>
+		void on_ready(Executor& ex, F fn)
+		{
+			detail::state<T>* src = std::exchange(s, nullptr);
+			src->attach([src, ex = &ex, fn = std::move(fn)]() mutable {
+				ex->execute([src, fn = std::move(fn)]() mutable { fn(future<T>(src)); });
+			});
+		}
+
+		// Runs fn(value) (fn() for future<void>) on `ex` once the value is set and
+		// returns a future for its result. An exception skips fn and propagates.
+		template <typename Executor, typename F>
+		auto then(Executor& ex, F fn)
+		{
+			using R = std::conditional_t<std::is_void<T>::value, std::invoke_result<F>, std::invoke_result<F, T>>;
+			using U = typename R::type;
+			promise<U> next;
+			future<U> result = next.get_future();
+			on_ready(ex, [fn = std::move(fn), next = std::move(next)](future<T> f) mutable {
+				try
+				{
+					if constexpr (std::is_void<T>::value && std::is_void<U>::value)
+					{
+						f.get();
+						fn();
+						next.set_value();
+					}
+					else if constexpr (std::is_void<T>::value)
+					{
+						f.get();
+						next.set_value(fn());
+					}
+					else if constexpr (std::is_void<U>::value)
+					{
+						fn(f.get());
+						next.set_value();
+					}
+					else
+					{
+						next.set_value(fn(f.get()));
+					}
+				}
+				catch (...)
+				{
+					next.set_exception(std::current_exception());
+				}
+			});
+			return result;
+		}
+
+		// then() on the thread that sets the value.
+		template <typename F>
+		auto then(F fn)
+		{
+			static inline_executor ex;
+			return then(ex, std::move(fn));
+		}
+	};
+
+	template <typename T>
+	future<std::decay_t<T>> make_ready_future(T&& value)
+	{
+		promise<std::decay_t<T>> p;
+		auto f = p.get_future();
+		p.set_value(std::forward<T>(value));
+		return f;
+	}
+
+	namespace detail
+	{
+		template <typename R>
+		struct gather
+		{
+			R values;
+			std::atomic<std::size_t> left;
+			std::atomic<bool> failed{ false };
+			promise<R> done;
+
+			gather(R init, std::size_t n) : values(std::move(init)), left(n) {}
+
+			void fail(std::exception_ptr e)
+			{
+				if (!failed.exchange(true, std::memory_order_acq_rel))
+				{
+					done.set_exception(std::move(e));
+				}
+			}
+
+			void arrive()
+			{
+				if (left.fetch_sub(1, std::memory_order_acq_rel) == 1 && !failed.load(std::memory_order_acquire))
+				{
+					done.set_value(std::move(values));
+				}
+			}
+		};
+
+		template <typename... Ts, std::size_t... I>
+		future<std::tuple<Ts...>> when_all(std::index_sequence<I...>, future<Ts>... inputs)
+		{
+			static inline_executor ex;
+			auto g = std::make_shared<gather<std::tuple<Ts...>>>(std::tuple<Ts...>(), sizeof...(Ts));
+			auto result = g->done.get_future();
+			(inputs.on_ready(ex, [g](future<Ts> f) {
+				try
+				{
+					std::get<I>(g->values) = f.get();
+				}
+				catch (...)
+				{
+					g->fail(std::current_exception());
+				}
+				g->arrive();
+			}), ...);
+			return result;
+		}
+	}
+
+	// Completes with every value once all inputs are ready, or with the first exception.
+	template <typename T>
+	future<std::vector<T>> when_all(std::vector<future<T>> inputs)
+	{
+		static inline_executor ex;
+		auto g = std::make_shared<detail::gather<std::vector<T>>>(std::vector<T>(inputs.size()), inputs.size());
+		auto result = g->done.get_future();
+		if (inputs.empty())
+		{
+			g->done.set_value(std::vector<T>());
+		}
+		for (std::size_t i = 0; i < inputs.size(); ++i)
+		{
+			inputs[i].on_ready(ex, [g, i](future<T> f) {
+				try
+				{
+					g->values[i] = f.get();
+				}
+				catch (...)
+				{
+					g->fail(std::current_exception());
+				}
+				g->arrive();
+			});
+		}
+		return result;
+	}
+
+	template <typename... Ts>
+	future<std::tuple<Ts...>> when_all(future<Ts>... inputs)
+	{
+		return detail::when_all(std::index_sequence_for<Ts...>(), std::move(inputs)...);
+	}
+
+	// Completes with (index, value) of the first input to succeed, or with the
+	// last exception if every input fails.
+	template <typename T>
+	future<std::pair<std::size_t, T>> when_any(std::vector<future<T>> inputs)
+	{
+		struct race
+		{
+			std::atomic<bool> won{ false };
+			std::atomic<std::size_t> failures{ 0 };
+			std::size_t count;
+			promise<std::pair<std::size_t, T>> done;
+		};
+		static inline_executor ex;
+		auto r = std::make_shared<race>();
+		r->count = inputs.size();
+		auto result = r->done.get_future();
+		for (std::size_t i = 0; i < inputs.size(); ++i)
+		{
+			inputs[i].on_ready(ex, [r, i](future<T> f) {
+				try
+				{
+					T v = f.get();
+					if (!r->won.exchange(true, std::memory_order_acq_rel))
+					{
+						r->done.set_value(std::make_pair(i, std::move(v)));
+					}
+				}
+				catch (...)
+				{
+					if (r->failures.fetch_add(1, std::memory_order_acq_rel) + 1 == r->count)
+					{
+						r->done.set_exception(std::current_exception());
+					}
+				}
+			});
+		}
+		return result;
+	}
+}
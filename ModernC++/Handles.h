@@ -0,0 +1,354 @@
+#pragma once
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+extern "C" __declspec(dllimport) void* __stdcall VirtualAlloc(void* address, std::size_t size, unsigned long type, unsigned long protect);
+extern "C" __declspec(dllimport) int __stdcall VirtualFree(void* address, std::size_t size, unsigned long type);
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "FlatHash.h"
+
+/*
+Resource handles
+A3 deletes its copy constructor and copy assignment so an object cannot be duplicated. unique_handle<Traits> applies the same rule to something that must be released exactly once, such as a file descriptor, a memory mapping or an aligned buffer. Copying is deleted and moving transfers ownership. The destructor releases the resource, and a moved-from handle is empty and releases nothing. Traits supplies the handle value, its "empty" value, and the release function.
+
+unique_fd wraps a file descriptor. unique_region wraps an anonymous read/write mapping (mmap, or VirtualAlloc on Windows). unique_buffer wraps memory from the aligned operator new.
+
+Handles taken from a recycle_pool go back to the pool when they are destroyed. The pool keeps a free list per size and alignment, so a program that repeatedly maps or allocates blocks of the same sizes reuses them, with no munmap/mmap pair (or free/malloc, which for large blocks is the same thing), and the pages stay faulted in. A pool caches at most max_cached_bytes and releases anything beyond that. A pool must outlive the handles taken from it.
+*/
+namespace handle
+{
+	// Move-only owner of one resource.
+	template <typename Traits>
+	class unique_handle
+	{
+	public:
+		using value_type = typename Traits::value_type;
+
+		unique_handle() noexcept : value(Traits::invalid()) {}
+		explicit unique_handle(value_type v) noexcept : value(v) {}
+
+		unique_handle(const unique_handle&) = delete;
+		unique_handle& operator=(const unique_handle&) = delete;
+
+		unique_handle(unique_handle&& o) noexcept : value(o.release()) {}
+		unique_handle& operator=(unique_handle&& o) noexcept
+		{
+			reset(o.release());
+			return *this;
+		}
+
+		~unique_handle() { reset(); }
+
+		const value_type& get() const noexcept { return value; }
+		explicit operator bool() const noexcept { return Traits::valid(value); }
+
+		// Gives up ownership without releasing.
+		value_type release() noexcept { return std::exchange(value, Traits::invalid()); }
+
+		void reset(value_type v = Traits::invalid()) noexcept
+		{
+			value_type old = std::exchange(value, v);
+			if (Traits::valid(old))
+			{
+				Traits::close(old);
+			}
+		}
+
+	private:
+		value_type value;
+	};
+
+	struct fd_traits
+	{
+		using value_type = int;
+		static int invalid() noexcept { return -1; }
+		static bool valid(int fd) noexcept { return fd >= 0; }
+		static void close(int fd) noexcept
+		{
+#if defined(_WIN32)
+			::_close(fd);
+#else
+			::close(fd);
+#endif
+		}
+	};
+
+	using unique_fd = unique_handle<fd_traits>;
+
+	// flags as for open(); an empty handle on failure.
+	inline unique_fd open_file(const char* path, int flags, int mode = 0644)
+	{
+#if defined(_WIN32)
+		return unique_fd(::_open(path, flags | _O_BINARY, mode));
+#else
+		return unique_fd(::open(path, flags | O_CLOEXEC, mode));
+#endif
+	}
+
+	// Anonymous read/write mappings. Counts the calls into the kernel.
+	struct region_kind
+	{
+		static inline std::atomic<std::size_t> obtained{ 0 }; // mmap calls
+		static inline std::atomic<std::size_t> released{ 0 }; // munmap calls
+
+		static std::size_t page_size()
+		{
+#if defined(_WIN32)
+			return 4096;
+#else
+			static const std::size_t size = std::size_t(::sysconf(_SC_PAGESIZE));
+			return size;
+#endif
+		}
+
+		static std::size_t round(std::size_t size, std::size_t)
+		{
+			const std::size_t page = page_size();
+			return (size + page - 1) / page * page;
+		}
+
+		static void* obtain(std::size_t size, std::size_t)
+		{
+			obtained.fetch_add(1, std::memory_order_relaxed);
+#if defined(_WIN32)
+			void* p = ::VirtualAlloc(nullptr, size, 0x1000 | 0x2000, 0x04); // MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE
+			if (!p)
+			{
+				throw std::bad_alloc();
+			}
+#else
+			void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (p == MAP_FAILED)
+			{
+				throw std::bad_alloc();
+			}
+#endif
+			return p;
+		}
+
+		static void give_up(void* p, std::size_t size, std::size_t) noexcept
+		{
+			released.fetch_add(1, std::memory_order_relaxed);
+#if defined(_WIN32)
+			(void)size;
+			::VirtualFree(p, 0, 0x8000); // MEM_RELEASE
+#else
+			::munmap(p, size);
+#endif
+		}
+	};
+
+	// Buffers from the aligned operator new. Counts the allocations.
+	struct buffer_kind
+	{
+		static inline std::atomic<std::size_t> obtained{ 0 };
+		static inline std::atomic<std::size_t> released{ 0 };
+
+		static std::size_t round(std::size_t size, std::size_t align) { return (size + align - 1) / align * align; }
+
+		static void* obtain(std::size_t size, std::size_t align)
+		{
+			obtained.fetch_add(1, std::memory_order_relaxed);
+			return ::operator new(size, std::align_val_t(align));
+		}
+
+		static void give_up(void* p, std::size_t size, std::size_t align) noexcept
+		{
+			released.fetch_add(1, std::memory_order_relaxed);
+			::operator delete(p, size, std::align_val_t(align));
+		}
+	};
+
+	template <typename Kind>
+	class recycle_pool;
+
+	template <typename Kind>
+	struct block
+	{
+		void* data = nullptr;
+		std::size_t size = 0;
+		std::size_t align = 0;
+		recycle_pool<Kind>* pool = nullptr; // null: release directly
+
+		template <typename T>
+		T* as() const { return static_cast<T*>(data); }
+	};
+
+	template <typename Kind>
+	struct block_traits
+	{
+		using value_type = block<Kind>;
+		static block<Kind> invalid() noexcept { return {}; }
+		static bool valid(const block<Kind>& b) noexcept { return b.data != nullptr; }
+		static void close(const block<Kind>& b) noexcept
+		{
+			if (b.pool)
+			{
+				b.pool->recycle(b);
+			}
+			else
+			{
+				Kind::give_up(b.data, b.size, b.align);
+			}
+		}
+	};
+
+	using unique_region = unique_handle<block_traits<region_kind>>;
+	using unique_buffer = unique_handle<block_traits<buffer_kind>>;
+
+	// size is rounded up to whole pages.
+	inline unique_region map_region(std::size_t size)
+	{
+		size = region_kind::round(size, 0);
+		return unique_region({ region_kind::obtain(size, 0), size, 0, nullptr });
+	}
+
+	// size is rounded up to a multiple of align, which must be a power of two.
+	inline unique_buffer allocate_buffer(std::size_t size, std::size_t align = 64)
+	{
+		size = buffer_kind::round(size, align);
+		return unique_buffer({ buffer_kind::obtain(size, align), size, align, nullptr });
+	}
+
+	template <typename Kind>
+	class recycle_pool
+	{
+	public:
+		using handle_type = unique_handle<block_traits<Kind>>;
+
+		struct stats
+		{
+			std::size_t acquired = 0;
+			std::size_t reused = 0;   // served from the free list
+			std::size_t overflow = 0; // returned blocks released because the cache was full (or out of memory)
+		};
+
+		explicit recycle_pool(std::size_t max_cached_bytes = std::size_t(64) << 20) : limit(max_cached_bytes) {}
+		recycle_pool(const recycle_pool&) = delete;
+		recycle_pool& operator=(const recycle_pool&) = delete;
+
+		~recycle_pool()
+		{
+			assert(outstanding == 0 && "recycle_pool destroyed while handles still point to it");
+			trim();
+		}
+
+		handle_type acquire(std::size_t size, std::size_t align = 64)
+		{
+			size = Kind::round(size, align);
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				++counters.acquired;
+				++outstanding;
+				auto it = free.find(key(size, align));
+				if (it != free.end() && !it->second.empty())
+				{
+					void* p = it->second.back();
+					it->second.pop_back();
+					cached -= size;
+					++counters.reused;
+					return handle_type({ p, size, align, this });
+				}
+			}
+			try
+			{
+				return handle_type({ Kind::obtain(size, align), size, align, this });
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				--outstanding;
+				throw;
+			}
+		}
+
+		// Called when a handle from this pool is destroyed.
+		void recycle(const block<Kind>& b) noexcept
+		{
+			{
+				std::lock_guard<std::mutex> lk(lock);
+				--outstanding;
+				if (cached + b.size <= limit)
+				{
+					// The free list may need memory; without it, release the block
+					// instead of letting the exception escape a destructor.
+					try
+					{
+						free[key(b.size, b.align)].push_back(b.data);
+						cached += b.size;
+						return;
+					}
+					catch (...)
+					{
+					}
+				}
+				++counters.overflow;
+			}
+			Kind::give_up(b.data, b.size, b.align);
+		}
+
+		// Releases every cached block.
+		void trim()
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			for (auto& kv : free)
+			{
+				const std::size_t size = std::size_t(kv.first >> 8);
+				const std::size_t align = std::size_t(1) << (kv.first & 0xff);
+				for (void* p : kv.second)
+				{
+					Kind::give_up(p, size, align);
+				}
+				kv.second.clear();
+			}
+			cached = 0;
+		}
+
+		stats statistics() const
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			return counters;
+		}
+
+		std::size_t cached_bytes() const
+		{
+			std::lock_guard<std::mutex> lk(lock);
+			return cached;
+		}
+
+	private:
+		static std::uint64_t key(std::size_t size, std::size_t align)
+		{
+			std::uint64_t log2 = 0;
+			while ((std::size_t(1) << log2) < align)
+			{
+				++log2;
+			}
+			return std::uint64_t(size) << 8 | log2;
+		}
+
+		mutable std::mutex lock;
+		flathash::flat_hash_map<std::uint64_t, std::vector<void*>> free;
+		std::size_t cached = 0;
+		std::size_t limit;
+		std::size_t outstanding = 0;
+		stats counters;
+	};
+
+	using region_pool = recycle_pool<region_kind>;
+	using buffer_pool = recycle_pool<buffer_kind>;
+}
@@ -0,0 +1,484 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ArrayKernels.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KERNELS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC and Clang need every function that uses an instruction set beyond the
+// baseline to be marked with it; MSVC accepts the intrinsics anywhere.
+#if defined(__GNUC__) || defined(__clang__)
+#define KERNEL_TARGET(isa) __attribute__((target(isa)))
+#else
+#define KERNEL_TARGET(isa)
+#endif
+
+/*
+Versioned kernel dispatch
+The hot kernels (sum, sort and the regex prefilter byte search) are compiled once per instruction set into their own namespace, the same way Program::Version1 keeps an older getVersion() around. The inline namespace Dispatch plays the role of Version2: an unqualified Kernels::sum() goes through a table picked once at startup from CPUID, while Kernels::Avx2::sum() still names one variant explicitly.
+
+Set MODERNC_KERNELS=scalar|sse4.2|avx2|avx512 to force a variant. A request for a variant the CPU cannot run falls back to the best supported one.
+*/
+namespace Kernels
+{
+	enum class Variant { Scalar, Sse42, Avx2, Avx512 };
+
+	namespace detail
+	{
+		// Bottom-up merge of sorted runs of length `run` in p[0, n).
+		inline void merge_runs(int* p, std::size_t n, std::size_t run)
+		{
+			if (run >= n)
+			{
+				return;
+			}
+			std::vector<int> buffer(n);
+			int* src = p;
+			int* dst = buffer.data();
+			for (std::size_t width = run; width < n; width *= 2)
+			{
+				for (std::size_t i = 0; i < n; i += 2 * width)
+				{
+					const std::size_t mid = std::min(i + width, n);
+					const std::size_t last = std::min(i + 2 * width, n);
+					std::merge(src + i, src + mid, src + mid, src + last, dst + i);
+				}
+				std::swap(src, dst);
+			}
+			if (src != p)
+			{
+				std::copy(src, src + n, p);
+			}
+		}
+
+		inline int first_set_bit(std::uint64_t mask)
+		{
+#if defined(_MSC_VER) && defined(_M_X64)
+			unsigned long index;
+			_BitScanForward64(&index, mask);
+			return static_cast<int>(index);
+#elif defined(_MSC_VER)
+			unsigned long index;
+			if (_BitScanForward(&index, static_cast<unsigned long>(mask))) return static_cast<int>(index);
+			_BitScanForward(&index, static_cast<unsigned long>(mask >> 32));
+			return static_cast<int>(index) + 32;
+#else
+			return __builtin_ctzll(mask);
+#endif
+		}
+
+		// Rows of an 8-row block are sorted column-wise by this network.
+		constexpr auto& block_network = array_kernels::detail::network<8>;
+		constexpr std::size_t block_rows = 8;
+	}
+
+	namespace Scalar
+	{
+		inline int sum(const int* p, std::size_t n)
+		{
+			// Wraps on overflow like the vector variants do.
+			unsigned total = 0;
+			for (std::size_t i = 0; i < n; ++i)
+			{
+				total += static_cast<unsigned>(p[i]);
+			}
+			return static_cast<int>(total);
+		}
+
+		inline void sort(int* p, std::size_t n)
+		{
+			std::sort(p, p + n);
+		}
+
+		inline const char* find_byte(const char* p, std::size_t n, char c)
+		{
+			return static_cast<const char*>(std::memchr(p, c, n));
+		}
+	}
+
+#if defined(KERNELS_X86)
+	namespace Sse42
+	{
+		KERNEL_TARGET("sse4.2") inline int sum(const int* p, std::size_t n)
+		{
+			__m128i acc = _mm_setzero_si128();
+			std::size_t i = 0;
+			for (; i + 4 <= n; i += 4)
+			{
+				acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i)));
+			}
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+			acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+			unsigned total = static_cast<unsigned>(_mm_cvtsi128_si32(acc));
+			for (; i < n; ++i)
+			{
+				total += static_cast<unsigned>(p[i]);
+			}
+			return static_cast<int>(total);
+		}
+
+		// Sorts 8x4 blocks column-wise with SIMD min/max, writes each column
+		// back as a sorted run of 8 and merges the runs.
+		KERNEL_TARGET("sse4.2") inline void sort(int* p, std::size_t n)
+		{
+			constexpr std::size_t lanes = 4;
+			constexpr std::size_t rows = detail::block_rows;
+			const std::size_t full = n / (lanes * rows) * (lanes * rows);
+			alignas(16) int tmp[rows][lanes];
+			for (std::size_t b = 0; b < full; b += lanes * rows)
+			{
+				__m128i v[rows];
+				for (std::size_t r = 0; r < rows; ++r)
+				{
+					v[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + b + r * lanes));
+				}
+				for (const auto& c : detail::block_network)
+				{
+					const __m128i lo = _mm_min_epi32(v[c.lo], v[c.hi]);
+					v[c.hi] = _mm_max_epi32(v[c.lo], v[c.hi]);
+					v[c.lo] = lo;
+				}
+				for (std::size_t r = 0; r < rows; ++r)
+				{
+					_mm_store_si128(reinterpret_cast<__m128i*>(tmp[r]), v[r]);
+				}
+				for (std::size_t l = 0; l < lanes; ++l)
+				{
+					for (std::size_t r = 0; r < rows; ++r)
+					{
+						p[b + l * rows + r] = tmp[r][l];
+					}
+				}
+			}
+			std::sort(p + full, p + n);
+			detail::merge_runs(p, n, rows);
+		}
+
+		KERNEL_TARGET("sse4.2") inline const char* find_byte(const char* p, std::size_t n, char c)
+		{
+			const __m128i needle = _mm_set1_epi8(c);
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+			{
+				const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+				const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle));
+				if (mask != 0)
+				{
+					return p + i + detail::first_set_bit(static_cast<std::uint64_t>(mask));
+				}
+			}
+			return Scalar::find_byte(p + i, n - i, c);
+		}
+	}
+
+	namespace Avx2
+	{
+		KERNEL_TARGET("avx2") inline int sum(const int* p, std::size_t n)
+		{
+			__m256i acc = _mm256_setzero_si256();
+			std::size_t i = 0;
+			for (; i + 8 <= n; i += 8)
+			{
+				acc = _mm256_add_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i)));
+			}
+			__m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+			half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+			half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+			unsigned total = static_cast<unsigned>(_mm_cvtsi128_si32(half));
+			for (; i < n; ++i)
+			{
+				total += static_cast<unsigned>(p[i]);
+			}
+			return static_cast<int>(total);
+		}
+
+		KERNEL_TARGET("avx2") inline void sort(int* p, std::size_t n)
+		{
+			constexpr std::size_t lanes = 8;
+			constexpr std::size_t rows = detail::block_rows;
+			const std::size_t full = n / (lanes * rows) * (lanes * rows);
+			alignas(32) int tmp[rows][lanes];
+			for (std::size_t b = 0; b < full; b += lanes * rows)
+			{
+				__m256i v[rows];
+				for (std::size_t r = 0; r < rows; ++r)
+				{
+					v[r] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + b + r * lanes));
+				}
+				for (const auto& c : detail::block_network)
+				{
+					const __m256i lo = _mm256_min_epi32(v[c.lo], v[c.hi]);
+					v[c.hi] = _mm256_max_epi32(v[c.lo], v[c.hi]);
+					v[c.lo] = lo;
+				}
+				for (std::size_t r = 0; r < rows; ++r)
+				{
+					_mm256_store_si256(reinterpret_cast<__m256i*>(tmp[r]), v[r]);
+				}
+				for (std::size_t l = 0; l < lanes; ++l)
+				{
+					for (std::size_t r = 0; r < rows; ++r)
+					{
+						p[b + l * rows + r] = tmp[r][l];
+					}
+				}
+			}
+			std::sort(p + full, p + n);
+			detail::merge_runs(p, n, rows);
+		}
+
+		KERNEL_TARGET("avx2") inline const char* find_byte(const char* p, std::size_t n, char c)
+		{
+			const __m256i needle = _mm256_set1_epi8(c);
+			std::size_t i = 0;
+			for (; i + 32 <= n; i += 32)
+			{
+				const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+				const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, needle)));
+				if (mask != 0)
+				{
+					return p + i + detail::first_set_bit(mask);
+				}
+			}
+			return Sse42::find_byte(p + i, n - i, c);
+		}
+	}
+
+	namespace Avx512
+	{
+		KERNEL_TARGET("avx512f") inline int sum(const int* p, std::size_t n)
+		{
+			__m512i acc = _mm512_setzero_si512();
+			std::size_t i = 0;
+			for (; i + 16 <= n; i += 16)
+			{
+				acc = _mm512_add_epi32(acc, _mm512_loadu_si512(p + i));
+			}
+			// The zero-masked extract: GCC 12's unmasked one passes an undefined
+			// vector through and warns about it (-Wuninitialized).
+			const __m256i quad = _mm256_add_epi32(_mm512_maskz_extracti64x4_epi64(0xff, acc, 0), _mm512_maskz_extracti64x4_epi64(0xff, acc, 1));
+			__m128i half = _mm_add_epi32(_mm256_castsi256_si128(quad), _mm256_extracti128_si256(quad, 1));
+			half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+			half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+			unsigned total = static_cast<unsigned>(_mm_cvtsi128_si32(half));
+			for (; i < n; ++i)
+			{
+				total += static_cast<unsigned>(p[i]);
+			}
+			return static_cast<int>(total);
+		}
+
+		KERNEL_TARGET("avx512f") inline void sort(int* p, std::size_t n)
+		{
+			constexpr std::size_t lanes = 16;
+			constexpr std::size_t rows = detail::block_rows;
+			const std::size_t full = n / (lanes * rows) * (lanes * rows);
+			alignas(64) int tmp[rows][lanes];
+			for (std::size_t b = 0; b < full; b += lanes * rows)
+			{
+				__m512i v[rows];
+				for (std::size_t r = 0; r < rows; ++r)
+				{
+					v[r] = _mm512_loadu_si512(p + b + r * lanes);
+				}
+				for (const auto& c : detail::block_network)
+				{
+					// All-lanes masked forms, for the same GCC 12 warning.
+					const __m512i lo = _mm512_mask_min_epi32(v[c.lo], 0xffff, v[c.lo], v[c.hi]);
+					v[c.hi] = _mm512_mask_max_epi32(v[c.hi], 0xffff, v[c.lo], v[c.hi]);
+					v[c.lo] = lo;
+				}
+				for (std::size_t r = 0; r < rows; ++r)
+				{
+					_mm512_store_si512(tmp[r], v[r]);
+				}
+				for (std::size_t l = 0; l < lanes; ++l)
+				{
+					for (std::size_t r = 0; r < rows; ++r)
+					{
+						p[b + l * rows + r] = tmp[r][l];
+					}
+				}
+			}
+			std::sort(p + full, p + n);
+			detail::merge_runs(p, n, rows);
+		}
+
+		KERNEL_TARGET("avx512f,avx512bw") inline const char* find_byte(const char* p, std::size_t n, char c)
+		{
+			const __m512i needle = _mm512_set1_epi8(c);
+			std::size_t i = 0;
+			for (; i + 64 <= n; i += 64)
+			{
+				const __mmask64 mask = _mm512_cmpeq_epi8_mask(_mm512_loadu_si512(p + i), needle);
+				if (mask != 0)
+				{
+					return p + i + detail::first_set_bit(mask);
+				}
+			}
+			return Avx2::find_byte(p + i, n - i, c);
+		}
+	}
+#endif
+
+	struct KernelTable
+	{
+		Variant variant;
+		const char* name;
+		int (*sum)(const int*, std::size_t);
+		void (*sort)(int*, std::size_t);
+		const char* (*find_byte)(const char*, std::size_t, char);
+	};
+
+	inline bool cpu_supports(Variant v)
+	{
+#if !defined(KERNELS_X86)
+		return v == Variant::Scalar;
+#elif defined(_MSC_VER)
+		int regs[4];
+		__cpuid(regs, 1);
+		const bool sse42 = (regs[2] & (1 << 20)) != 0;
+		const bool osxsave = (regs[2] & (1 << 27)) != 0;
+		const unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+		const bool ymm = (xcr0 & 0x6) == 0x6;
+		const bool zmm = (xcr0 & 0xe6) == 0xe6;
+		__cpuidex(regs, 7, 0);
+		const bool avx2 = ymm && (regs[1] & (1 << 5)) != 0;
+		const bool avx512 = zmm && (regs[1] & (1 << 16)) != 0 && (regs[1] & (1 << 30)) != 0;
+		switch (v)
+		{
+		case Variant::Scalar: return true;
+		case Variant::Sse42: return sse42;
+		case Variant::Avx2: return avx2;
+		case Variant::Avx512: return avx512;
+		}
+		return false;
+#else
+		switch (v)
+		{
+		case Variant::Scalar: return true;
+		case Variant::Sse42: return __builtin_cpu_supports("sse4.2");
+		case Variant::Avx2: return __builtin_cpu_supports("avx2");
+		case Variant::Avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+		}
+		return false;
+#endif
+	}
+
+	// The kernel table of one variant, whether or not this CPU can run it.
+	inline const KernelTable& table_for(Variant v)
+	{
+		static const KernelTable scalar{ Variant::Scalar, "scalar", Scalar::sum, Scalar::sort, Scalar::find_byte };
+#if defined(KERNELS_X86)
+		static const KernelTable sse42{ Variant::Sse42, "sse4.2", Sse42::sum, Sse42::sort, Sse42::find_byte };
+		static const KernelTable avx2{ Variant::Avx2, "avx2", Avx2::sum, Avx2::sort, Avx2::find_byte };
+		static const KernelTable avx512{ Variant::Avx512, "avx512", Avx512::sum, Avx512::sort, Avx512::find_byte };
+		switch (v)
+		{
+		case Variant::Sse42: return sse42;
+		case Variant::Avx2: return avx2;
+		case Variant::Avx512: return avx512;
+		default: break;
+		}
+#endif
+		return scalar;
+	}
+
+	inline Variant best_supported(Variant limit = Variant::Avx512)
+	{
+		for (int v = static_cast<int>(limit); v > 0; --v)
+		{
+			if (cpu_supports(static_cast<Variant>(v)))
+			{
+				return static_cast<Variant>(v);
+			}
+		}
+		return Variant::Scalar;
+	}
+
+	// Reads MODERNC_KERNELS; returns false when unset or unrecognised.
+	inline bool forced_variant(Variant& out)
+	{
+		std::string value;
+#if defined(_MSC_VER)
+		char* buffer = nullptr;
+		std::size_t length = 0;
+		if (_dupenv_s(&buffer, &length, "MODERNC_KERNELS") == 0 && buffer != nullptr)
+		{
+			value = buffer;
+			std::free(buffer);
+		}
+#else
+		if (const char* env = std::getenv("MODERNC_KERNELS"))
+		{
+			value = env;
+		}
+#endif
+		for (Variant v : { Variant::Scalar, Variant::Sse42, Variant::Avx2, Variant::Avx512 })
+		{
+			if (value == table_for(v).name)
+			{
+				out = v;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	inline namespace Dispatch
+	{
+		// Selected on first use and fixed for the rest of the process.
+		inline const KernelTable& active()
+		{
+			static const KernelTable& table = []() -> const KernelTable& {
+				Variant v = Variant::Avx512;
+				forced_variant(v);
+				return table_for(best_supported(v));
+			}();
+			return table;
+		}
+
+		inline int sum(const int* p, std::size_t n) { return active().sum(p, n); }
+		inline void sort(int* p, std::size_t n) { active().sort(p, n); }
+		inline const char* find_byte(const char* p, std::size_t n, char c) { return active().find_byte(p, n, c); }
+
+		// True when `text` contains `literal`. Used to skip running a regex on
+		// inputs that lack one of its required literal substrings.
+		inline bool prefilter(std::string_view text, std::string_view literal)
+		{
+			if (literal.empty())
+			{
+				return true;
+			}
+			const char* p = text.data();
+			const char* end = text.data() + text.size();
+			while (static_cast<std::size_t>(end - p) >= literal.size())
+			{
+				p = find_byte(p, static_cast<std::size_t>(end - p) - literal.size() + 1, literal[0]);
+				if (p == nullptr)
+				{
+					return false;
+				}
+				if (std::memcmp(p, literal.data(), literal.size()) == 0)
+				{
+					return true;
+				}
+				++p;
+			}
+			return false;
+		}
+	}
+}
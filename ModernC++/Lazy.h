@@ -0,0 +1,382 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ArrayKernels.h"
+#include "Maybe.h"
+#include "SmallVector.h"
+
+/*
+Lazy range pipelines
+A source produces values one at a time through next(), which returns an empty maybe<T> when it is exhausted. Views such as map, filter, take, chunk and zip wrap another source and are composed with operator|, so the whole pipeline inlines into a single loop and never materializes a vector between stages:
+
+auto gen = [x = 0]() mutable { return x++; };
+auto evens = lazy::generate(gen) | lazy::filter(isEven) | lazy::take(10);
+
+Sources with a known size (iota, from) can be sliced, which lets parallel_reduce() run a chain of stateless stages (map, filter) over independent chunks.
+*/
+namespace lazy
+{
+	// Lets a pipeline drive a C++17 range-based for loop.
+	struct sentinel {};
+
+	template <typename View>
+	class input_iterator
+	{
+		View* view;
+		maybe<typename View::value_type> current;
+
+	public:
+		using value_type = typename View::value_type;
+
+		explicit input_iterator(View& v) : view(&v), current(v.next()) {}
+		const value_type& operator*() const { return *current; }
+		input_iterator& operator++()
+		{
+			current = view->next();
+			return *this;
+		}
+		bool operator!=(sentinel) const { return current.has_value(); }
+	};
+
+	template <typename Derived>
+	struct view_base
+	{
+		input_iterator<Derived> begin() { return input_iterator<Derived>(static_cast<Derived&>(*this)); }
+		sentinel end() const { return {}; }
+	};
+
+	///////////////////////////////////////////////////////////////////////
+	// Sources
+	///////////////////////////////////////////////////////////////////////
+
+	// Infinite source calling a (possibly mutable) generator.
+	template <typename Gen>
+	class generate_view : public view_base<generate_view<Gen>>
+	{
+		Gen gen;
+
+	public:
+		using value_type = std::decay_t<std::invoke_result_t<Gen&>>;
+		static constexpr bool sliceable = false;
+
+		explicit generate_view(Gen g) : gen(std::move(g)) {}
+		maybe<value_type> next() { return gen(); }
+	};
+
+	template <typename Gen>
+	generate_view<Gen> generate(Gen g)
+	{
+		return generate_view<Gen>(std::move(g));
+	}
+
+	// Integers in [first, last).
+	template <typename T>
+	class iota_view : public view_base<iota_view<T>>
+	{
+		T cur;
+		T last;
+
+	public:
+		using value_type = T;
+		static constexpr bool sliceable = true;
+
+		iota_view(T first, T last) : cur(first), last(last) {}
+		maybe<T> next() { return cur < last ? maybe<T>(cur++) : maybe<T>(); }
+		std::size_t size() const { return cur < last ? static_cast<std::size_t>(last - cur) : 0; } // 0 when first > last, as next() sees it
+		iota_view slice(std::size_t a, std::size_t b) const
+		{
+			return iota_view(static_cast<T>(cur + static_cast<T>(a)), static_cast<T>(cur + static_cast<T>(b)));
+		}
+	};
+
+	template <typename T>
+	iota_view<T> iota(T first, T last)
+	{
+		return iota_view<T>(first, last);
+	}
+
+	// Elements of a random-access range, by value.
+	template <typename It>
+	class from_view : public view_base<from_view<It>>
+	{
+		It cur;
+		It last;
+
+	public:
+		using value_type = typename std::iterator_traits<It>::value_type;
+		static constexpr bool sliceable = true;
+
+		from_view(It first, It last) : cur(first), last(last) {}
+		maybe<value_type> next() { return cur != last ? maybe<value_type>(*cur++) : maybe<value_type>(); }
+		std::size_t size() const { return static_cast<std::size_t>(last - cur); }
+		from_view slice(std::size_t a, std::size_t b) const { return from_view(cur + a, cur + b); }
+	};
+
+	template <typename Container>
+	auto from(const Container& c)
+	{
+		return from_view<decltype(std::begin(c))>(std::begin(c), std::end(c));
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Views
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename Src, typename F>
+	class map_view : public view_base<map_view<Src, F>>
+	{
+		Src src;
+		F f;
+
+	public:
+		using value_type = std::decay_t<std::invoke_result_t<F&, const typename Src::value_type&>>;
+
+		map_view(Src s, F fn) : src(std::move(s)), f(std::move(fn)) {}
+		maybe<value_type> next()
+		{
+			auto v = src.next();
+			return v ? maybe<value_type>(std::invoke(f, *v)) : maybe<value_type>();
+		}
+	};
+
+	template <typename Src, typename P>
+	class filter_view : public view_base<filter_view<Src, P>>
+	{
+		Src src;
+		P pred;
+
+	public:
+		using value_type = typename Src::value_type;
+
+		filter_view(Src s, P p) : src(std::move(s)), pred(std::move(p)) {}
+		maybe<value_type> next()
+		{
+			while (auto v = src.next())
+			{
+				if (std::invoke(pred, *v))
+				{
+					return v;
+				}
+			}
+			return {};
+		}
+	};
+
+	template <typename Src>
+	class take_view : public view_base<take_view<Src>>
+	{
+		Src src;
+		std::size_t left;
+
+	public:
+		using value_type = typename Src::value_type;
+
+		take_view(Src s, std::size_t n) : src(std::move(s)), left(n) {}
+		maybe<value_type> next()
+		{
+			if (left == 0)
+			{
+				return {};
+			}
+			--left;
+			return src.next();
+		}
+	};
+
+	// Groups of up to n consecutive values; groups of 16 or fewer stay inline.
+	template <typename Src>
+	class chunk_view : public view_base<chunk_view<Src>>
+	{
+		Src src;
+		std::size_t n;
+
+	public:
+		using value_type = small_vector<typename Src::value_type, 16>;
+
+		chunk_view(Src s, std::size_t n) : src(std::move(s)), n(n) {}
+		maybe<value_type> next()
+		{
+			value_type chunk;
+			while (chunk.size() < n)
+			{
+				auto v = src.next();
+				if (!v)
+				{
+					break;
+				}
+				chunk.push_back(std::move(*v));
+			}
+			return chunk.empty() ? maybe<value_type>() : maybe<value_type>(std::move(chunk));
+		}
+	};
+
+	// Pairs up two sources; ends with the shorter one.
+	template <typename A, typename B>
+	class zip_view : public view_base<zip_view<A, B>>
+	{
+		A a;
+		B b;
+
+	public:
+		using value_type = std::pair<typename A::value_type, typename B::value_type>;
+
+		zip_view(A a, B b) : a(std::move(a)), b(std::move(b)) {}
+		maybe<value_type> next()
+		{
+			auto x = a.next();
+			if (!x)
+			{
+				return {};
+			}
+			auto y = b.next();
+			if (!y)
+			{
+				return {};
+			}
+			return value_type(std::move(*x), std::move(*y));
+		}
+	};
+
+	template <typename A, typename B>
+	zip_view<A, B> zip(A a, B b)
+	{
+		return zip_view<A, B>(std::move(a), std::move(b));
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Adaptors: `source | adaptor` builds the view, `adaptor | adaptor` composes
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename F>
+	struct map_adaptor
+	{
+		F f;
+		static constexpr bool stateless = true;
+		template <typename Src>
+		auto apply(Src s) const { return map_view<Src, F>(std::move(s), f); }
+	};
+
+	template <typename P>
+	struct filter_adaptor
+	{
+		P pred;
+		static constexpr bool stateless = true;
+		template <typename Src>
+		auto apply(Src s) const { return filter_view<Src, P>(std::move(s), pred); }
+	};
+
+	struct take_adaptor
+	{
+		std::size_t n;
+		static constexpr bool stateless = false;
+		template <typename Src>
+		auto apply(Src s) const { return take_view<Src>(std::move(s), n); }
+	};
+
+	struct chunk_adaptor
+	{
+		std::size_t n;
+		static constexpr bool stateless = false;
+		template <typename Src>
+		auto apply(Src s) const { return chunk_view<Src>(std::move(s), n); }
+	};
+
+	template <typename First, typename Second>
+	struct composed_adaptor
+	{
+		First first;
+		Second second;
+		static constexpr bool stateless = First::stateless && Second::stateless;
+		template <typename Src>
+		auto apply(Src s) const { return second.apply(first.apply(std::move(s))); }
+	};
+
+	template <typename F>
+	map_adaptor<F> map(F f) { return { std::move(f) }; }
+
+	template <typename P>
+	filter_adaptor<P> filter(P pred) { return { std::move(pred) }; }
+
+	inline take_adaptor take(std::size_t n) { return { n }; }
+
+	inline chunk_adaptor chunk(std::size_t n) { return { n }; }
+
+	template <typename T, typename = void>
+	struct is_adaptor : std::false_type {};
+
+	template <typename T>
+	struct is_adaptor<T, std::void_t<decltype(T::stateless)>> : std::true_type {};
+
+	template <typename Src, typename Adaptor,
+		typename = std::enable_if_t<!is_adaptor<Src>::value && is_adaptor<Adaptor>::value>>
+	auto operator|(Src src, const Adaptor& adaptor)
+	{
+		return adaptor.apply(std::move(src));
+	}
+
+	template <typename First, typename Second,
+		typename = std::enable_if_t<is_adaptor<First>::value && is_adaptor<Second>::value>, typename = void>
+	composed_adaptor<First, Second> operator|(First first, Second second)
+	{
+		return { std::move(first), std::move(second) };
+	}
+
+	///////////////////////////////////////////////////////////////////////
+	// Terminal operations
+	///////////////////////////////////////////////////////////////////////
+
+	template <typename View, typename T, typename Op>
+	T reduce(View view, T init, Op op)
+	{
+		while (auto v = view.next())
+		{
+			init = op(std::move(init), std::move(*v));
+		}
+		return init;
+	}
+
+	template <typename View, typename F>
+	void for_each(View view, F f)
+	{
+		while (auto v = view.next())
+		{
+			f(*v);
+		}
+	}
+
+	// Materializes the pipeline; only call this where a container is really needed.
+	template <typename View>
+	std::vector<typename View::value_type> to_vector(View view)
+	{
+		std::vector<typename View::value_type> out;
+		while (auto v = view.next())
+		{
+			out.push_back(std::move(*v));
+		}
+		return out;
+	}
+
+	// Applies `stages` to slices of `src` on all hardware threads and folds the
+	// partial results. `identity` must be the identity of `op`, and `op` must be
+	// associative and commutative. Only map and filter may appear in `stages`.
+	template <typename Src, typename Stages, typename T, typename Op>
+	T parallel_reduce(const Src& src, const Stages& stages, T identity, Op op, std::size_t min_chunk = 1 << 16)
+	{
+		static_assert(Src::sliceable, "parallel_reduce needs a sliceable source such as iota() or from()");
+		static_assert(Stages::stateless, "take and chunk depend on element order and cannot be split");
+		std::mutex m;
+		T total = identity;
+		array_kernels::parallel_chunks(src.size(), [&](std::size_t first, std::size_t last) {
+			T partial = reduce(stages.apply(src.slice(first, last)), identity, op);
+			std::lock_guard<std::mutex> lk(m);
+			total = op(std::move(total), std::move(partial));
+		}, min_chunk);
+		return total;
+	}
+}
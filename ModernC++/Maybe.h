@@ -0,0 +1,213 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+/*
+maybe and result
+An optional/expected family for lookup paths where neither success nor failure may allocate. maybe<T> holds a cheap value such as a std::string_view, maybe<T&> is an optional reference that is just a pointer, and result<T, E> carries either a value or an error.
+
+All three support monadic chaining: and_then(f) calls f with the value and returns what f returns, transform(f) wraps f's return value, and or_else(f) is only called on failure.
+*/
+template <typename T>
+class maybe;
+
+namespace maybe_detail
+{
+	template <typename T>
+	struct is_maybe : std::false_type {};
+
+	template <typename T>
+	struct is_maybe<maybe<T>> : std::true_type {};
+}
+
+template <typename T>
+class maybe
+{
+	std::optional<T> v;
+
+public:
+	using value_type = T;
+
+	constexpr maybe() noexcept = default;
+	constexpr maybe(std::nullopt_t) noexcept {}
+	constexpr maybe(T value) : v(std::move(value)) {}
+
+	constexpr bool has_value() const noexcept { return v.has_value(); }
+	constexpr explicit operator bool() const noexcept { return v.has_value(); }
+
+	constexpr const T& operator*() const& { return *v; }
+	constexpr T& operator*() & { return *v; }
+	constexpr const T* operator->() const { return &*v; }
+	constexpr const T& value() const& { return v.value(); }
+
+	template <typename U>
+	constexpr T value_or(U&& fallback) const&
+	{
+		return v ? *v : static_cast<T>(std::forward<U>(fallback));
+	}
+
+	template <typename F>
+	constexpr auto and_then(F&& f) const&
+	{
+		using R = std::invoke_result_t<F, const T&>;
+		static_assert(maybe_detail::is_maybe<R>::value, "and_then expects a function returning maybe<U>");
+		return v ? std::invoke(std::forward<F>(f), *v) : R{};
+	}
+
+	template <typename F>
+	constexpr auto transform(F&& f) const&
+	{
+		using R = maybe<std::invoke_result_t<F, const T&>>;
+		return v ? R(std::invoke(std::forward<F>(f), *v)) : R{};
+	}
+
+	template <typename F>
+	constexpr maybe or_else(F&& f) const&
+	{
+		return v ? *this : maybe(std::invoke(std::forward<F>(f)));
+	}
+};
+
+// An optional reference: one pointer, no ownership and no copy of the referent.
+template <typename T>
+class maybe<T&>
+{
+	T* p = nullptr;
+
+public:
+	using value_type = T&;
+
+	constexpr maybe() noexcept = default;
+	constexpr maybe(std::nullopt_t) noexcept {}
+	constexpr maybe(T& ref) noexcept : p(&ref) {}
+	maybe(T&&) = delete; // would dangle
+
+	constexpr bool has_value() const noexcept { return p != nullptr; }
+	constexpr explicit operator bool() const noexcept { return p != nullptr; }
+
+	constexpr T& operator*() const noexcept { return *p; }
+	constexpr T* operator->() const noexcept { return p; }
+
+	constexpr T& value() const
+	{
+		if (!p) throw std::bad_optional_access();
+		return *p;
+	}
+
+	constexpr T& value_or(T& fallback) const noexcept { return p ? *p : fallback; }
+	T& value_or(T&&) const = delete; // would return a reference to the temporary
+
+	template <typename F>
+	constexpr auto and_then(F&& f) const
+	{
+		using R = std::invoke_result_t<F, T&>;
+		static_assert(maybe_detail::is_maybe<R>::value, "and_then expects a function returning maybe<U>");
+		return p ? std::invoke(std::forward<F>(f), *p) : R{};
+	}
+
+	template <typename F>
+	constexpr auto transform(F&& f) const
+	{
+		using R = maybe<std::invoke_result_t<F, T&>>;
+		return p ? R(std::invoke(std::forward<F>(f), *p)) : R{};
+	}
+
+	template <typename F>
+	constexpr maybe or_else(F&& f) const
+	{
+		return p ? *this : maybe(std::invoke(std::forward<F>(f)));
+	}
+};
+
+template <typename E>
+struct failure
+{
+	E error;
+};
+
+template <typename E>
+constexpr failure<std::decay_t<E>> fail(E&& e)
+{
+	return { std::forward<E>(e) };
+}
+
+// Either a value or an error. Use an error type that does not allocate (an
+// enum or a std::string_view) to keep the failure path allocation-free too.
+template <typename T, typename E>
+class result
+{
+	std::variant<T, failure<E>> v;
+
+public:
+	using value_type = T;
+	using error_type = E;
+
+	constexpr result(T value) : v(std::in_place_index<0>, std::move(value)) {}
+	constexpr result(failure<E> f) : v(std::in_place_index<1>, std::move(f)) {}
+	// fail("not found") makes a failure<const char*>; accept it for E = std::string_view.
+	template <typename G, typename = std::enable_if_t<!std::is_same<G, E>::value && std::is_convertible<G, E>::value>>
+	constexpr result(failure<G> f) : v(std::in_place_index<1>, failure<E>{ E(std::move(f.error)) }) {}
+
+	constexpr bool has_value() const noexcept { return v.index() == 0; }
+	constexpr explicit operator bool() const noexcept { return v.index() == 0; }
+
+	constexpr const T& operator*() const& { return *std::get_if<0>(&v); }
+	constexpr const T* operator->() const { return std::get_if<0>(&v); }
+	constexpr const T& value() const& { return std::get<0>(v); }
+	constexpr const E& error() const& { return std::get<1>(v).error; }
+
+	template <typename U>
+	constexpr T value_or(U&& fallback) const&
+	{
+		return has_value() ? **this : static_cast<T>(std::forward<U>(fallback));
+	}
+
+	template <typename F>
+	constexpr auto and_then(F&& f) const&
+	{
+		using R = std::invoke_result_t<F, const T&>;
+		return has_value() ? std::invoke(std::forward<F>(f), **this) : R(failure<E>{ error() });
+	}
+
+	template <typename F>
+	constexpr auto transform(F&& f) const&
+	{
+		using R = result<std::invoke_result_t<F, const T&>, E>;
+		return has_value() ? R(std::invoke(std::forward<F>(f), **this)) : R(failure<E>{ error() });
+	}
+
+	template <typename F>
+	constexpr result or_else(F&& f) const&
+	{
+		return has_value() ? *this : result(std::invoke(std::forward<F>(f), error()));
+	}
+};
+
+/*
+Lookups built on maybe. Neither a hit nor a miss allocates: the literal is viewed in place and map entries are returned by reference.
+*/
+constexpr maybe<std::string_view> create_view(bool b)
+{
+	if (b)
+	{
+		return std::string_view("Godzilla");
+	}
+	return {};
+}
+
+template <typename Key, typename Value, typename Compare, typename Alloc>
+maybe<const Value&> find_value(const std::map<Key, Value, Compare, Alloc>& m, const Key& key)
+{
+	auto it = m.find(key);
+	if (it == m.end())
+	{
+		return {};
+	}
+	return it->second;
+}
@@ -0,0 +1,202 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "FlatHash.h"
+
+/*
+Memoization
+memoize(f, capacity) wraps a pure function in a thread-safe cache keyed on the tuple of its arguments; a miss calls the function through std::apply on that tuple. The cache is split into shards, each guarded by a shared_mutex, so hits from many threads only take shared locks. Each shard holds at most capacity / shards results and evicts with the CLOCK algorithm: a hit just sets a "referenced" bit, and the eviction hand skips (and clears) entries whose bit is set, which approximates LRU without reordering anything on a read.
+
+Calls whose arguments are constant expressions do not need a cache at all: memo::constant<factorial, 10> is evaluated by the compiler.
+*/
+namespace memo
+{
+	// Compile-time evaluation for constant arguments; never touches a cache.
+	template <auto Fn, auto... Args>
+	constexpr auto constant = Fn(Args...);
+
+	struct cache_stats
+	{
+		std::uint64_t hits = 0;
+		std::uint64_t misses = 0;
+		std::uint64_t evictions = 0;
+
+		double hit_rate() const { return hits + misses == 0 ? 0.0 : double(hits) / double(hits + misses); }
+	};
+
+	template <typename Tuple>
+	struct tuple_hash
+	{
+		std::uint64_t operator()(const Tuple& t) const
+		{
+			return std::apply([](const auto&... e) {
+				std::uint64_t h = 0;
+				((h = flathash::mix(h * 0x9e3779b97f4a7c15ull + flathash::hash<std::decay_t<decltype(e)>>()(e))), ...);
+				return h;
+			}, t);
+		}
+	};
+
+	template <typename F, typename R, typename... Args>
+	class memoizer
+	{
+	public:
+		using key_type = std::tuple<std::decay_t<Args>...>;
+		using result_type = R;
+
+		memoizer(F fn, std::size_t capacity, std::size_t shard_count = 16)
+			: f(std::move(fn)), shard_mask(round_up(shard_count) - 1), shards(shard_mask + 1)
+		{
+			const std::size_t per_shard = capacity / shards.size() > 0 ? capacity / shards.size() : 1;
+			for (auto& s : shards)
+			{
+				s.capacity = per_shard;
+				s.referenced = std::make_unique<std::atomic<bool>[]>(per_shard);
+				s.entries.reserve(per_shard);
+				s.index.reserve(per_shard);
+			}
+		}
+
+		memoizer(const memoizer&) = delete;
+		memoizer& operator=(const memoizer&) = delete;
+
+		R operator()(const Args&... args)
+		{
+			key_type key(args...);
+			shard& s = shards[(tuple_hash<key_type>()(key) >> 32) & shard_mask];
+			{
+				std::shared_lock<std::shared_mutex> lk(s.m);
+				auto it = s.index.find(key);
+				if (it != s.index.end())
+				{
+					s.referenced[it->second].store(true, std::memory_order_relaxed);
+					s.hits.fetch_add(1, std::memory_order_relaxed);
+					return s.entries[it->second].second;
+				}
+			}
+			s.misses.fetch_add(1, std::memory_order_relaxed);
+
+			// Computed without the lock held, so a slow call does not stall the shard.
+			// Two threads missing on the same key both compute it; the first insert wins.
+			R value = std::apply(f, key);
+
+			std::unique_lock<std::shared_mutex> lk(s.m);
+			if (s.index.find(key) != s.index.end())
+			{
+				return value;
+			}
+			std::uint32_t slot;
+			if (s.entries.size() < s.capacity)
+			{
+				slot = static_cast<std::uint32_t>(s.entries.size());
+				s.entries.emplace_back(key, value);
+			}
+			else
+			{
+				while (s.referenced[s.hand].exchange(false, std::memory_order_relaxed))
+				{
+					s.hand = (s.hand + 1) % s.capacity;
+				}
+				slot = static_cast<std::uint32_t>(s.hand);
+				s.hand = (s.hand + 1) % s.capacity;
+				s.index.erase(s.entries[slot].first);
+				s.entries[slot] = { key, value };
+				s.evictions.fetch_add(1, std::memory_order_relaxed);
+			}
+			s.index.try_emplace(std::move(key), slot);
+			return value;
+		}
+
+		cache_stats stats() const
+		{
+			cache_stats total;
+			for (const auto& s : shards)
+			{
+				total.hits += s.hits.load(std::memory_order_relaxed);
+				total.misses += s.misses.load(std::memory_order_relaxed);
+				total.evictions += s.evictions.load(std::memory_order_relaxed);
+			}
+			return total;
+		}
+
+		std::size_t size() const
+		{
+			std::size_t n = 0;
+			for (const auto& s : shards)
+			{
+				std::shared_lock<std::shared_mutex> lk(s.m);
+				n += s.entries.size();
+			}
+			return n;
+		}
+
+		void clear()
+		{
+			for (auto& s : shards)
+			{
+				std::unique_lock<std::shared_mutex> lk(s.m);
+				s.index.clear();
+				s.entries.clear();
+				for (std::size_t i = 0; i < s.capacity; ++i) s.referenced[i].store(false, std::memory_order_relaxed);
+				s.hand = 0;
+			}
+		}
+
+	private:
+		struct shard
+		{
+			mutable std::shared_mutex m;
+			flathash::flat_hash_map<key_type, std::uint32_t, tuple_hash<key_type>> index;
+			std::vector<std::pair<key_type, R>> entries;
+			std::unique_ptr<std::atomic<bool>[]> referenced;
+			std::size_t capacity = 0;
+			std::size_t hand = 0;
+			std::atomic<std::uint64_t> hits{ 0 };
+			std::atomic<std::uint64_t> misses{ 0 };
+			std::atomic<std::uint64_t> evictions{ 0 };
+		};
+
+		static std::size_t round_up(std::size_t n)
+		{
+			std::size_t p = 1;
+			while (p < n) p *= 2;
+			return p;
+		}
+
+		F f;
+		std::size_t shard_mask;
+		std::vector<shard> shards;
+	};
+
+	// Free functions: memo::memoize(factorial, 1024)
+	template <typename R, typename... Args>
+	memoizer<R(*)(Args...), R, Args...> memoize(R(*fn)(Args...), std::size_t capacity, std::size_t shard_count = 16)
+	{
+		return memoizer<R(*)(Args...), R, Args...>(fn, capacity, shard_count);
+	}
+
+	// Other callables name their signature: memo::memoize<int(int, int)>(add, 1024)
+	template <typename Sig, typename F>
+	struct memoizer_for;
+
+	template <typename R, typename... Args, typename F>
+	struct memoizer_for<R(Args...), F>
+	{
+		using type = memoizer<F, R, Args...>;
+	};
+
+	template <typename Sig, typename F>
+	typename memoizer_for<Sig, F>::type memoize(F fn, std::size_t capacity, std::size_t shard_count = 16)
+	{
+		return typename memoizer_for<Sig, F>::type(std::move(fn), capacity, shard_count);
+	}
+}
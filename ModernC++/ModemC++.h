@@ -1,14 +1,23 @@
 #pragma once
 #include <memory>
+#include "PageAlloc.h"
 class widget
 {
 private:
     std::unique_ptr<int> data;
     int iweight;
+    pagealloc::buffer payload; // empty unless allocate_payload() is called
 public:
     widget(const int size) : iweight (size)
     {
     }
     void do_something() { data = std::make_unique<int>(iweight); }
     int weight() const { return iweight; }
+
+    // Opt-in storage for large payloads, aligned as `where` asks.
+    void allocate_payload(std::size_t bytes, pagealloc::placement where = pagealloc::placement::cache_line)
+    {
+        payload = pagealloc::allocate(bytes, where);
+    }
+    const pagealloc::buffer& payload_buffer() const { return payload; }
 };
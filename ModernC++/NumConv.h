@@ -0,0 +1,129 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "Maybe.h"
+
+/*
+Number conversion
+Locale-free number <-> text conversion into caller-provided buffers, built on std::to_chars/std::from_chars. Doubles are written in the shortest form that parses back to the same value ("1.2", where std::to_string gives "1.200000"), so parse(format(x)) == x for every finite x.
+
+format_column() writes a whole column of numbers into one contiguous buffer with a single allocation, instead of one std::string per value.
+*/
+namespace numconv
+{
+	// Buffer size that always fits one value of T.
+	template <typename T>
+	constexpr std::size_t max_chars()
+	{
+		static_assert(std::is_arithmetic<T>::value, "numconv works on arithmetic types");
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			// sign, 17 significant digits, '.', 'e', exponent sign, 3-4 exponent digits
+			return 32;
+		}
+		else
+		{
+			return std::numeric_limits<T>::digits10 + 3;
+		}
+	}
+
+	// Writes `value` to [first, last) and returns one past the last written
+	// character, or nullptr if the buffer is too small.
+	template <typename T>
+	char* write(char* first, char* last, T value)
+	{
+		const auto r = std::to_chars(first, last, value);
+		return r.ec == std::errc() ? r.ptr : nullptr;
+	}
+
+	template <typename T, std::size_t N>
+	std::string_view format(char (&buf)[N], T value)
+	{
+		static_assert(N >= max_chars<T>(), "buffer too small for this type");
+		return std::string_view(buf, static_cast<std::size_t>(write(buf, buf + N, value) - buf));
+	}
+
+	template <typename T>
+	void append(std::string& out, T value)
+	{
+		char buf[max_chars<T>()];
+		out.append(format(buf, value));
+	}
+
+	// Parses the whole of `text`; trailing characters, overflow or an empty string fail.
+	template <typename T>
+	maybe<T> parse(std::string_view text)
+	{
+		T value{};
+		const char* last = text.data() + text.size();
+		const auto r = std::from_chars(text.data(), last, value);
+		if (r.ec != std::errc() || r.ptr != last)
+		{
+			return {};
+		}
+		return value;
+	}
+
+	// A column of numbers rendered back to back in one buffer; entry i is
+	// buffer[offsets[i], offsets[i + 1]).
+	struct formatted_column
+	{
+		std::string buffer;
+		std::vector<std::size_t> offsets;
+
+		std::size_t size() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+		std::string_view operator[](std::size_t i) const
+		{
+			return std::string_view(buffer.data() + offsets[i], offsets[i + 1] - offsets[i]);
+		}
+	};
+
+	template <typename T>
+	formatted_column format_column(const T* values, std::size_t n)
+	{
+		formatted_column col;
+		col.buffer.resize(n * max_chars<T>());
+		col.offsets.resize(n + 1);
+		char* const base = &col.buffer[0];
+		char* out = base;
+		char* const end = base + col.buffer.size();
+		col.offsets[0] = 0;
+		for (std::size_t i = 0; i < n; ++i)
+		{
+			out = write(out, end, values[i]);
+			col.offsets[i + 1] = static_cast<std::size_t>(out - base);
+		}
+		col.buffer.resize(static_cast<std::size_t>(out - base));
+		return col;
+	}
+
+	template <typename T>
+	formatted_column format_column(const std::vector<T>& values)
+	{
+		return format_column(values.data(), values.size());
+	}
+
+	// Inverse of format_column; fails if any entry does not parse.
+	template <typename T>
+	maybe<std::vector<T>> parse_column(const formatted_column& col)
+	{
+		std::vector<T> out(col.size());
+		for (std::size_t i = 0; i < col.size(); ++i)
+		{
+			auto v = parse<T>(col[i]);
+			if (!v)
+			{
+				return {};
+			}
+			out[i] = *v;
+		}
+		return out;
+	}
+}
@@ -0,0 +1,509 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#elif defined(_WIN32)
+extern "C" __declspec(dllimport) void* __stdcall GetCurrentThread();
+extern "C" __declspec(dllimport) std::uintptr_t __stdcall SetThreadAffinityMask(void* thread, std::uintptr_t mask);
+#endif
+
+#include "Futures.h"
+#include "PageAlloc.h"
+#include "Queues.h"
+
+/*
+NUMA-aware thread pool
+On a machine with several NUMA nodes, each socket has its own memory, and a load from another node's memory takes longer and shares the interconnect's bandwidth. Linux places a page on the node of the thread that first writes it (first touch). numa::thread_pool therefore keeps one task queue and one group of workers per node, and each worker is pinned to that node's CPUs. pool.allocate(node, bytes) returns an arena whose pages the node's own workers wrote first, so they sit in that node's memory. execute_near(arena, fn) then runs fn on that node. A task submitted to a node stays there, and idle workers do not steal from other nodes, because a stolen task would read its data remotely.
+
+The topology comes from /sys/devices/system/node: the "online" list of nodes and each node's cpulist and distance row, parsed directly without libnuma. Nodes with memory but no CPUs are dropped, and detect() also drops the CPUs the process may not run on (taskset, cgroups). Where sysfs is missing (other platforms, containers without /sys), detect() reports one node with every hardware thread, and the pool works like fut::thread_pool with pinned workers. topology::simulate(nodes, cpus) builds a pretend layout over the CPUs that exist, so the per-node scheduling can be exercised on any machine. Placement there is only nominal, because every "node" shares the same memory. from_sysfs(dir) reads a tree laid out like sysfs, such as a copy taken from a larger machine.
+
+The pool is also an executor for fut::future::then(). execute(fn) from one of its workers queues fn on that worker's node, so a chain of continuations stays near the data it started with.
+*/
+namespace numa
+{
+	// "0-3,8-11" -> 0 1 2 3 8 9 10 11, the format of sysfs cpulist and online
+	// files. Whitespace is ignored; an unparsable list yields nothing.
+	inline std::vector<int> parse_cpu_list(std::string_view text)
+	{
+		std::vector<int> out;
+		std::size_t i = 0;
+		auto number = [&](int& v) {
+			const std::size_t start = i;
+			v = 0;
+			for (; i < text.size() && text[i] >= '0' && text[i] <= '9'; ++i)
+			{
+				v = v * 10 + (text[i] - '0');
+			}
+			return i != start;
+		};
+		while (i < text.size())
+		{
+			if (text[i] == ',' || text[i] == ' ' || text[i] == '\n' || text[i] == '\t')
+			{
+				++i;
+				continue;
+			}
+			int lo, hi;
+			if (!number(lo))
+			{
+				return {};
+			}
+			hi = lo;
+			if (i < text.size() && text[i] == '-')
+			{
+				++i;
+				if (!number(hi) || hi < lo)
+				{
+					return {};
+				}
+			}
+			for (int c = lo; c <= hi; ++c)
+			{
+				out.push_back(c);
+			}
+		}
+		return out;
+	}
+
+	struct node
+	{
+		int id = 0;                // the kernel's node number
+		std::vector<int> cpus;
+		std::vector<int> distance; // to every node of the topology, by index; 10 means local
+	};
+
+	struct topology
+	{
+		std::vector<node> nodes;
+		bool simulated = false;
+
+		std::size_t node_count() const { return nodes.size(); }
+
+		std::size_t cpu_count() const
+		{
+			std::size_t n = 0;
+			for (const node& nd : nodes)
+			{
+				n += nd.cpus.size();
+			}
+			return n;
+		}
+
+		// Index into nodes of the node the CPU belongs to, or -1.
+		int node_of_cpu(int cpu) const
+		{
+			for (std::size_t i = 0; i < nodes.size(); ++i)
+			{
+				if (std::find(nodes[i].cpus.begin(), nodes[i].cpus.end(), cpu) != nodes[i].cpus.end())
+				{
+					return int(i);
+				}
+			}
+			return -1;
+		}
+
+		// The node other than `from` with the greatest distance (from itself if alone).
+		std::size_t farthest(std::size_t from) const
+		{
+			std::size_t best = from;
+			for (std::size_t i = 0; i < nodes.size(); ++i)
+			{
+				if (i != from && (best == from || nodes[from].distance[i] > nodes[from].distance[best]))
+				{
+					best = i;
+				}
+			}
+			return best;
+		}
+
+		// One node holding every hardware thread.
+		static topology single()
+		{
+			const int n = int(std::max(1u, std::thread::hardware_concurrency()));
+			topology t;
+			t.nodes.resize(1);
+			for (int c = 0; c < n; ++c)
+			{
+				t.nodes[0].cpus.push_back(c);
+			}
+			t.nodes[0].distance = { 10 };
+			return t;
+		}
+
+		// `nodes` nodes of `cpus_per_node` CPUs each. The CPU numbers wrap around
+		// the hardware threads that exist, so workers can still be pinned.
+		static topology simulate(std::size_t nodes, std::size_t cpus_per_node)
+		{
+			const std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+			topology t;
+			t.simulated = true;
+			t.nodes.resize(std::max<std::size_t>(1, nodes));
+			for (std::size_t i = 0; i < t.nodes.size(); ++i)
+			{
+				t.nodes[i].id = int(i);
+				for (std::size_t c = 0; c < std::max<std::size_t>(1, cpus_per_node); ++c)
+				{
+					t.nodes[i].cpus.push_back(int((i * cpus_per_node + c) % hw));
+				}
+				for (std::size_t j = 0; j < t.nodes.size(); ++j)
+				{
+					t.nodes[i].distance.push_back(i == j ? 10 : 20);
+				}
+			}
+			return t;
+		}
+
+		// Reads a sysfs-style node directory; an empty topology if it cannot.
+		static topology from_sysfs(const std::string& dir = "/sys/devices/system/node")
+		{
+			topology t;
+			const std::vector<int> online = parse_cpu_list(read(dir + "/online"));
+			for (int id : online)
+			{
+				const std::string base = dir + "/node" + std::to_string(id);
+				node nd;
+				nd.id = id;
+				nd.cpus = parse_cpu_list(read(base + "/cpulist"));
+				// The distance row lists every online node, in order, separated by spaces.
+				const std::string row = read(base + "/distance");
+				for (std::size_t i = 0; i < row.size();)
+				{
+					if (row[i] < '0' || row[i] > '9')
+					{
+						++i;
+						continue;
+					}
+					int d = 0;
+					for (; i < row.size() && row[i] >= '0' && row[i] <= '9'; ++i)
+					{
+						d = d * 10 + (row[i] - '0');
+					}
+					nd.distance.push_back(d);
+				}
+				nd.distance.resize(online.size(), 0);
+				for (std::size_t j = 0; j < online.size(); ++j)
+				{
+					if (nd.distance[j] == 0)
+					{
+						nd.distance[j] = online[j] == id ? 10 : 20;
+					}
+				}
+				t.nodes.push_back(std::move(nd));
+			}
+			t.prune();
+			return t;
+		}
+
+		// sysfs when it is there, otherwise single(). Only the CPUs this process
+		// may run on (taskset, cgroups) are kept.
+		static topology detect()
+		{
+			topology t = from_sysfs();
+			for (node& nd : t.nodes)
+			{
+				nd.cpus.erase(std::remove_if(nd.cpus.begin(), nd.cpus.end(), [](int c) { return !allowed(c); }), nd.cpus.end());
+			}
+			t.prune();
+			return t.nodes.empty() ? single() : t;
+		}
+
+		// Drops nodes without CPUs (memory-only nodes), and their distance columns.
+		void prune()
+		{
+			for (std::size_t i = nodes.size(); i-- > 0;)
+			{
+				if (nodes[i].cpus.empty())
+				{
+					nodes.erase(nodes.begin() + std::ptrdiff_t(i));
+					for (node& nd : nodes)
+					{
+						if (i < nd.distance.size())
+						{
+							nd.distance.erase(nd.distance.begin() + std::ptrdiff_t(i));
+						}
+					}
+				}
+			}
+		}
+
+	private:
+		static std::string read(const std::string& path)
+		{
+			std::string text;
+			if (std::FILE* f = std::fopen(path.c_str(), "r"))
+			{
+				char chunk[256];
+				std::size_t n;
+				while ((n = std::fread(chunk, 1, sizeof chunk, f)) > 0)
+				{
+					text.append(chunk, n);
+				}
+				std::fclose(f);
+			}
+			return text;
+		}
+
+		// Whether this process may run on the CPU.
+		static bool allowed(int cpu)
+		{
+#if defined(__linux__)
+			cpu_set_t set;
+			if (cpu < 0 || cpu >= CPU_SETSIZE || ::sched_getaffinity(0, sizeof set, &set) != 0)
+			{
+				return cpu >= 0;
+			}
+			return CPU_ISSET(cpu, &set);
+#else
+			return cpu >= 0;
+#endif
+		}
+	};
+
+	// Restricts the calling thread to the CPUs; false if the platform refused.
+	inline bool pin_current_thread(const std::vector<int>& cpus)
+	{
+#if defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (int c : cpus)
+		{
+			if (c >= 0 && c < CPU_SETSIZE)
+			{
+				CPU_SET(c, &set);
+			}
+		}
+		return ::pthread_setaffinity_np(::pthread_self(), sizeof set, &set) == 0;
+#elif defined(_WIN32)
+		std::uintptr_t mask = 0;
+		for (int c : cpus)
+		{
+			if (c >= 0 && c < int(sizeof(mask) * 8))
+			{
+				mask |= std::uintptr_t(1) << c;
+			}
+		}
+		return mask && ::SetThreadAffinityMask(::GetCurrentThread(), mask) != 0;
+#else
+		(void)cpus;
+		return false;
+#endif
+	}
+
+	// The kernel's node number for the page holding p, or -1 if unknown
+	// (not Linux, not yet faulted in, or the call is not permitted).
+	inline int node_of_address(const void* p)
+	{
+#if defined(__linux__) && defined(SYS_get_mempolicy)
+		int id = -1;
+		constexpr unsigned long mpol_f_node = 1, mpol_f_addr = 2;
+		if (::syscall(SYS_get_mempolicy, &id, nullptr, 0ul, p, mpol_f_node | mpol_f_addr) == 0)
+		{
+			return id;
+		}
+#else
+		(void)p;
+#endif
+		return -1;
+	}
+
+	// Memory first touched on one node of a pool.
+	struct arena
+	{
+		pagealloc::buffer memory;
+		std::size_t node = 0; // index into the pool's topology
+
+		template <typename T = unsigned char>
+		T* data() const { return memory.data<T>(); }
+		std::size_t size() const { return memory.size(); }
+	};
+
+	class thread_pool;
+
+	namespace detail
+	{
+		// The pool and node of the calling worker thread.
+		struct where
+		{
+			const thread_pool* pool = nullptr;
+			std::size_t node = 0;
+		};
+		inline thread_local where current;
+	}
+
+	class thread_pool
+	{
+		using queue = queues::blocking_queue<queues::mpmc_queue<fut::detail::task>>;
+
+	public:
+		static constexpr std::size_t npos = std::size_t(-1);
+
+		// threads_per_node = 0 starts one worker per CPU of each node.
+		explicit thread_pool(topology t = topology::detect(), std::size_t threads_per_node = 0, std::size_t capacity = 1 << 14)
+			: layout(std::move(t))
+		{
+			if (layout.nodes.empty())
+			{
+				layout = topology::single();
+			}
+			for (std::size_t n = 0; n < layout.nodes.size(); ++n)
+			{
+				lanes.emplace_back(new queue(capacity));
+				per_node.push_back(threads_per_node ? threads_per_node : layout.nodes[n].cpus.size());
+			}
+			for (std::size_t n = 0; n < layout.nodes.size(); ++n)
+			{
+				for (std::size_t i = 0; i < per_node[n]; ++i)
+				{
+					workers.emplace_back([this, n] {
+						if (pin_current_thread(layout.nodes[n].cpus))
+						{
+							pinned.fetch_add(1, std::memory_order_relaxed);
+						}
+						detail::current = { this, n };
+						fut::detail::task t;
+						while (lanes[n]->pop(t))
+						{
+							t();
+							t.reset();
+						}
+					});
+				}
+			}
+		}
+
+		~thread_pool()
+		{
+			for (auto& q : lanes)
+			{
+				q->close();
+			}
+			for (auto& w : workers)
+			{
+				w.join();
+			}
+		}
+
+		thread_pool(const thread_pool&) = delete;
+		thread_pool& operator=(const thread_pool&) = delete;
+
+		const topology& layout_info() const { return layout; }
+		std::size_t node_count() const { return layout.nodes.size(); }
+		std::size_t workers_on(std::size_t node) const { return per_node[node]; }
+		// Workers whose affinity was set; less than the total where pinning is unsupported.
+		std::size_t pinned_workers() const { return pinned.load(std::memory_order_relaxed); }
+
+		// The node of the calling worker thread, or npos for other threads.
+		std::size_t current_node() const { return detail::current.pool == this ? detail::current.node : npos; }
+
+		// Once the pool is closing, runs f on the calling thread instead, as
+		// fut::thread_pool does, so submit() and parallel_on() still complete.
+		template <typename F>
+		void execute_on(std::size_t node, F&& f)
+		{
+			fut::detail::task t(std::forward<F>(f));
+			if (!lanes[node % lanes.size()]->push(std::move(t)))
+			{
+				t();
+			}
+		}
+
+		// From a worker: on that worker's node. Otherwise: round robin.
+		template <typename F>
+		void execute(F&& f)
+		{
+			const std::size_t here = current_node();
+			execute_on(here != npos ? here : next.fetch_add(1, std::memory_order_relaxed), std::forward<F>(f));
+		}
+
+		template <typename F>
+		void execute_near(const arena& data, F&& f) { execute_on(data.node, std::forward<F>(f)); }
+
+		template <typename F>
+		auto submit(std::size_t node, F f) -> fut::future<std::invoke_result_t<F>>
+		{
+			using R = std::invoke_result_t<F>;
+			fut::promise<R> p;
+			fut::future<R> result = p.get_future();
+			execute_on(node, [p = std::move(p), f = std::move(f)]() mutable {
+				try
+				{
+					if constexpr (std::is_void<R>::value)
+					{
+						f();
+						p.set_value();
+					}
+					else
+					{
+						p.set_value(f());
+					}
+				}
+				catch (...)
+				{
+					p.set_exception(std::current_exception());
+				}
+			});
+			return result;
+		}
+
+		// Splits [0, count) into one slice per worker of the node, runs
+		// fn(begin, end) on that node and waits. Call it from outside the pool:
+		// a worker waiting here holds a thread its own slices may need.
+		template <typename F>
+		void parallel_on(std::size_t node, std::size_t count, F fn)
+		{
+			node %= lanes.size();
+			const std::size_t parts = std::max<std::size_t>(1, std::min(per_node[node], count));
+			std::vector<fut::future<void>> done;
+			for (std::size_t i = 0; i < parts; ++i)
+			{
+				const std::size_t begin = count * i / parts, end = count * (i + 1) / parts;
+				done.push_back(submit(node, [&fn, begin, end] { fn(begin, end); }));
+			}
+			for (auto& f : done)
+			{
+				f.get();
+			}
+		}
+
+		// Pages on `node`: the node's workers write every page first, so the
+		// kernel allocates them from that node's memory. Blocks until done.
+		// With placement::cache_line the heap may hand out pages that were
+		// already touched elsewhere, so the default maps fresh pages.
+		arena allocate(std::size_t node, std::size_t bytes, pagealloc::placement where = pagealloc::placement::page)
+		{
+			arena a{ pagealloc::allocate(bytes, where), node % lanes.size() };
+			unsigned char* p = a.data();
+			const std::size_t page = pagealloc::page_size();
+			parallel_on(a.node, (bytes + page - 1) / page, [p, page](std::size_t begin, std::size_t end) {
+				for (std::size_t i = begin; i < end; ++i)
+				{
+					p[i * page] = 0;
+				}
+			});
+			return a;
+		}
+
+	private:
+		topology layout;
+		std::vector<std::unique_ptr<queue>> lanes;
+		std::vector<std::size_t> per_node;
+		std::vector<std::thread> workers;
+		std::atomic<std::size_t> pinned{ 0 };
+		std::atomic<std::size_t> next{ 0 };
+	};
+}
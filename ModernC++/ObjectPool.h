@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Handles.h"
+
+/*
+Object pool
+Creating a million small objects with new (or std::make_unique) makes a million calls into the allocator, and each object carries the allocator's header and lands wherever a free block happened to be. objpool::pool<T> carves objects out of slabs: arrays of slab_size objects in one 64-byte aligned allocation (a handle::unique_buffer). Destroyed objects go on a free list and are reused first. The slabs are released when the pool is destroyed, so every object must have been destroyed by then.
+
+create_n(n, out) builds n objects at once. Reused slots are constructed one at a time. The rest come from unused space at the end of the current slab, or from new slabs, as contiguous runs, and each run is constructed in one step. With no arguments a run is value-initialized with std::uninitialized_value_construct_n, which for a trivially default-constructible T is one fill of the run with T(), a memset when T() is all zero bytes. Other types run their constructor in a tight loop over the run. For Foo_DC, whose default constructor delegates to Foo_DC(0), or Human_11, whose member initializer sets age to 0, the constructor inlines into that loop and the compiler can turn it into a plain fill. destroy_n skips the destructor calls when T is trivially destructible.
+*/
+namespace objpool
+{
+	template <typename T, std::size_t SlabSize = std::max(std::size_t(64), (std::size_t(64) << 10) / sizeof(T))>
+	class pool
+	{
+	public:
+		static constexpr std::size_t slab_size = SlabSize;
+
+		pool() = default;
+		pool(const pool&) = delete;
+		pool& operator=(const pool&) = delete;
+
+		~pool() { assert(count == 0 && "objpool::pool destroyed with live objects"); }
+
+		template <typename... Args>
+		T* create(Args&&... args)
+		{
+			T* p = take_one();
+			try
+			{
+				::new (static_cast<void*>(p)) T(std::forward<Args>(args)...);
+			}
+			catch (...)
+			{
+				free.push_back(p);
+				throw;
+			}
+			++count;
+			return p;
+		}
+
+		void destroy(T* p)
+		{
+			p->~T();
+			free.push_back(p);
+			--count;
+		}
+
+		// Creates n objects, each as T(args...), and writes their addresses to out.
+		// All or nothing: if a constructor throws, the objects this call already
+		// built are destroyed, the pool is left as it was, and nothing has been
+		// written to out.
+		template <typename Out, typename... Args>
+		Out create_n(std::size_t n, Out out, const Args&... args)
+		{
+			// Reused slots are constructed where they sit on the free list and
+			// only taken off it once every object exists.
+			const std::size_t reused = std::min(n, free.size());
+			const std::size_t base = free.size() - reused;
+			std::size_t built = 0;
+			const T* old_next = next;
+			const T* old_end = end;
+			const std::size_t old_slabs = slabs.size();
+			std::vector<std::pair<T*, std::size_t>> runs;
+			try
+			{
+				for (; built < reused; ++built)
+				{
+					::new (static_cast<void*>(free[base + built])) T(args...);
+				}
+				for (std::size_t left = n - reused; left > 0;)
+				{
+					if (next == end)
+					{
+						grow();
+					}
+					const std::size_t run = std::min(left, std::size_t(end - next));
+					runs.emplace_back(next, 0);
+					construct_run(next, run, args...);
+					runs.back().second = run;
+					next += run;
+					left -= run;
+				}
+			}
+			catch (...)
+			{
+				for (const auto& r : runs)
+				{
+					std::destroy_n(r.first, r.second);
+				}
+				while (built > 0)
+				{
+					free[base + --built]->~T();
+				}
+				// Every slab added by this call is empty again; give them back.
+				slabs.resize(old_slabs);
+				next = const_cast<T*>(old_next);
+				end = const_cast<T*>(old_end);
+				throw;
+			}
+
+			for (std::size_t i = 0; i < reused; ++i)
+			{
+				*out++ = free[base + i];
+			}
+			free.resize(base);
+			for (const auto& r : runs)
+			{
+				for (std::size_t i = 0; i < r.second; ++i)
+				{
+					*out++ = r.first + i;
+				}
+			}
+			count += n;
+			return out;
+		}
+
+		// Destroys the objects whose addresses are in [first, last).
+		template <typename It>
+		void destroy_n(It first, It last)
+		{
+			for (; first != last; ++first)
+			{
+				T* p = *first;
+				if constexpr (!std::is_trivially_destructible<T>::value)
+				{
+					p->~T();
+				}
+				free.push_back(p);
+				--count;
+			}
+		}
+
+		std::size_t size() const { return count; }
+		std::size_t slab_count() const { return slabs.size(); }
+		std::size_t capacity() const { return slabs.size() * slab_size; }
+
+	private:
+		T* take_one()
+		{
+			if (!free.empty())
+			{
+				T* p = free.back();
+				free.pop_back();
+				return p;
+			}
+			if (next == end)
+			{
+				grow();
+			}
+			return next++;
+		}
+
+		void grow()
+		{
+			slabs.push_back(handle::allocate_buffer(slab_size * sizeof(T), std::max(alignof(T), std::size_t(64))));
+			next = slabs.back().get().template as<T>();
+			end = next + slab_size;
+		}
+
+		// Constructs n objects at p. Leaves no object behind if a constructor throws.
+		template <typename... Args>
+		static void construct_run(T* p, std::size_t n, const Args&... args)
+		{
+			if constexpr (sizeof...(Args) == 0)
+			{
+				// For a trivial T the library fills the run with copies of T(), which
+				// the compiler turns into a memset when T() is all zero bytes. It is
+				// not always: a null pointer to data member is -1 on the Itanium ABI.
+				std::uninitialized_value_construct_n(p, n);
+			}
+			else
+			{
+				std::size_t i = 0;
+				try
+				{
+					for (; i < n; ++i)
+					{
+						::new (static_cast<void*>(p + i)) T(args...);
+					}
+				}
+				catch (...)
+				{
+					std::destroy_n(p, i);
+					throw;
+				}
+			}
+		}
+
+		std::vector<handle::unique_buffer> slabs;
+		std::vector<T*> free;
+		T* next = nullptr; // never-used space in the last slab
+		T* end = nullptr;
+		std::size_t count = 0;
+	};
+}
@@ -0,0 +1,232 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#if defined(__linux__)
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "Handles.h"
+
+/*
+Large aligned buffers
+Memory for multi-megabyte payloads, aligned to what the access pattern needs. placement::cache_line gives 64-byte alignment from the heap, so SIMD loads never split a line. placement::page gives a private mapping of whole pages. placement::huge_page asks for 2 MiB pages. A 256 MiB buffer then needs 128 TLB entries instead of 65536, and a first-touch pass takes 128 page faults instead of 65536.
+
+On Linux, huge_page first tries an explicit huge-page mapping (MAP_HUGETLB, served from the pages reserved in /proc/sys/vm/nr_hugepages). If none are reserved, it maps a 2 MiB-aligned range and marks it with madvise(MADV_HUGEPAGE) so transparent huge pages back it. buffer::info() says which of these happened. huge_backed_bytes() reads /proc/self/smaps to report how much of the buffer the kernel actually placed on huge pages. On other platforms, huge_page falls back to ordinary pages.
+
+The buffer is a move-only handle (see Handles.h) and releases its memory with whatever obtained it.
+*/
+namespace pagealloc
+{
+	enum class placement { cache_line, page, huge_page };
+	enum class backing { heap, pages, huge_tlb, transparent_huge };
+
+	constexpr std::size_t cache_line = 64;
+	constexpr std::size_t huge_page_size = std::size_t(2) << 20;
+
+	inline std::size_t page_size() { return handle::region_kind::page_size(); }
+
+	struct stats
+	{
+		placement requested = placement::cache_line;
+		backing used = backing::heap;
+		std::size_t bytes = 0;     // as requested
+		std::size_t reserved = 0;  // after rounding up to the page size
+		std::size_t page_bytes = 0; // size of the pages backing it, as far as the allocator knows
+
+		// TLB entries needed to map the whole buffer.
+		std::size_t pages() const { return page_bytes ? (reserved + page_bytes - 1) / page_bytes : 0; }
+	};
+
+	namespace detail
+	{
+		struct mapping
+		{
+			void* data = nullptr;
+			std::size_t size = 0;
+			backing kind = backing::heap;
+		};
+
+		struct mapping_traits
+		{
+			using value_type = mapping;
+			static mapping invalid() noexcept { return {}; }
+			static bool valid(const mapping& m) noexcept { return m.data != nullptr; }
+			static void close(const mapping& m) noexcept
+			{
+				if (m.kind == backing::heap)
+				{
+					::operator delete(m.data, m.size, std::align_val_t(cache_line));
+				}
+				else
+				{
+					handle::region_kind::give_up(m.data, m.size, 0);
+				}
+			}
+		};
+
+		inline std::size_t round_up(std::size_t n, std::size_t to) { return (n + to - 1) / to * to; }
+
+#if defined(__linux__)
+		// 2 MiB-aligned anonymous mapping: map one huge page more than needed
+		// and unmap the unaligned head and the tail.
+		inline void* map_huge_aligned(std::size_t size)
+		{
+			const std::size_t span = size + huge_page_size;
+			char* raw = static_cast<char*>(::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			if (raw == MAP_FAILED)
+			{
+				throw std::bad_alloc();
+			}
+			const std::uintptr_t start = round_up(reinterpret_cast<std::uintptr_t>(raw), huge_page_size);
+			char* aligned = reinterpret_cast<char*>(start);
+			if (aligned != raw)
+			{
+				::munmap(raw, std::size_t(aligned - raw));
+			}
+			const std::size_t tail = std::size_t(raw + span - (aligned + size));
+			if (tail)
+			{
+				::munmap(aligned + size, tail);
+			}
+			return aligned;
+		}
+#endif
+	}
+
+	class buffer
+	{
+		handle::unique_handle<detail::mapping_traits> memory;
+		stats meta;
+
+	public:
+		buffer() = default;
+		buffer(detail::mapping m, const stats& s) : memory(m), meta(s) {}
+
+		template <typename T = unsigned char>
+		T* data() const { return static_cast<T*>(memory.get().data); }
+		std::size_t size() const { return meta.bytes; }
+		explicit operator bool() const { return static_cast<bool>(memory); }
+		const stats& info() const { return meta; }
+
+		// Bytes of this buffer the kernel currently backs with transparent or
+		// explicit huge pages (0 where this cannot be queried).
+		std::size_t huge_backed_bytes() const
+		{
+#if defined(__linux__)
+			if (!memory || meta.used == backing::heap)
+			{
+				return 0;
+			}
+			if (meta.used == backing::huge_tlb)
+			{
+				return meta.reserved;
+			}
+			std::FILE* f = std::fopen("/proc/self/smaps", "r");
+			if (!f)
+			{
+				return 0;
+			}
+			const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(memory.get().data);
+			const std::uintptr_t last = first + memory.get().size;
+			std::size_t total = 0;
+			bool inside = false;
+			char line[512];
+			while (std::fgets(line, sizeof line, f))
+			{
+				unsigned long long lo, hi;
+				if (std::sscanf(line, "%llx-%llx ", &lo, &hi) == 2)
+				{
+					// A mapping header ("lo-hi perms ..."); the kernel may have merged
+					// or split our range, so count every mapping that overlaps it.
+					inside = lo < last && hi > first;
+					continue;
+				}
+				std::size_t kb;
+				if (inside && std::sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+				{
+					total += kb * 1024;
+				}
+			}
+			std::fclose(f);
+			return total < meta.reserved ? total : meta.reserved;
+#else
+			return 0;
+#endif
+		}
+	};
+
+	// Never returns an empty buffer; throws std::bad_alloc on failure.
+	inline buffer allocate(std::size_t bytes, placement where = placement::cache_line)
+	{
+		stats s;
+		s.requested = where;
+		s.bytes = bytes;
+		detail::mapping m;
+
+		if (where == placement::cache_line)
+		{
+			s.reserved = detail::round_up(bytes ? bytes : 1, cache_line);
+			s.page_bytes = page_size();
+			m = { ::operator new(s.reserved, std::align_val_t(cache_line)), s.reserved, backing::heap };
+			s.used = backing::heap;
+			return buffer(m, s);
+		}
+
+#if defined(__linux__)
+		if (where == placement::huge_page)
+		{
+			s.reserved = detail::round_up(bytes ? bytes : 1, huge_page_size);
+			s.page_bytes = huge_page_size;
+			void* p = ::mmap(nullptr, s.reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (p != MAP_FAILED)
+			{
+				s.used = backing::huge_tlb;
+				handle::region_kind::obtained.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				p = detail::map_huge_aligned(s.reserved);
+				handle::region_kind::obtained.fetch_add(1, std::memory_order_relaxed);
+				// Even when the advice is taken, transparent huge pages set to "never"
+				// leave the range on 4 KiB pages; huge_backed_bytes() shows that.
+				// A kernel without them rejects the call, and the range is plain pages.
+				if (::madvise(p, s.reserved, MADV_HUGEPAGE) == 0)
+				{
+					s.used = backing::transparent_huge;
+				}
+				else
+				{
+					s.used = backing::pages;
+					s.page_bytes = page_size();
+				}
+			}
+			m = { p, s.reserved, s.used };
+			return buffer(m, s);
+		}
+#endif
+
+		s.reserved = handle::region_kind::round(bytes ? bytes : 1, 0);
+		s.page_bytes = page_size();
+		s.used = backing::pages;
+		m = { handle::region_kind::obtain(s.reserved, 0), s.reserved, backing::pages };
+		return buffer(m, s);
+	}
+
+	// Minor page faults taken by the process so far (0 where unsupported).
+	inline std::size_t minor_faults()
+	{
+#if defined(__linux__)
+		rusage u;
+		::getrusage(RUSAGE_SELF, &u);
+		return std::size_t(u.ru_minflt);
+#else
+		return 0;
+#endif
+	}
+}
@@ -0,0 +1,239 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+/*
+Type-sorted polymorphic storage
+A std::vector<std::unique_ptr<Base>> scatters its objects over the heap, and when it is iterated, consecutive virtual calls jump between unrelated functions. poly::collection<Base> keeps one contiguous std::vector per dynamic type (a segment) and visits the segments one after another. Within a segment, every virtual call has the same target, so the indirect branch is predicted and the function stays in the instruction cache. The objects are read sequentially too.
+
+for_each<Ts...>(fn) passes elements of the listed types as their concrete type, so calls to a final class or to non-virtual members can be inlined. All other elements go through Base&. Insertion appends to the element's segment. erase() moves the last element of the segment into the hole, so order is not kept and erasing is O(1). Like std::vector, inserting may move the elements of that segment, and references to them become invalid.
+
+An object is stored as the type it is inserted as: insert(T) with T a base of the real type slices it, just as a std::vector<T> would. Element types must be movable.
+*/
+namespace poly
+{
+	template <typename Base>
+	class collection
+	{
+		class segment_base
+		{
+		public:
+			const std::type_info* type;
+			std::size_t stride; // sizeof the element type
+
+			segment_base(const std::type_info* type, std::size_t stride) : type(type), stride(stride) {}
+			virtual ~segment_base() = default;
+
+			virtual std::size_t size() const = 0;
+			virtual Base* first() = 0; // Base subobject of element 0
+			virtual void swap_remove(std::size_t i) = 0;
+			virtual void clear() = 0;
+
+			Base* at(Base* base, std::size_t i) const
+			{
+				// Every element has its Base subobject at the same offset, so the
+				// Base subobjects are also `stride` bytes apart.
+				return reinterpret_cast<Base*>(reinterpret_cast<char*>(base) + i * stride);
+			}
+		};
+
+		template <typename T>
+		class segment final : public segment_base
+		{
+		public:
+			std::vector<T> items;
+
+			segment() : segment_base(&typeid(T), sizeof(T)) {}
+
+			std::size_t size() const override { return items.size(); }
+			Base* first() override { return items.empty() ? nullptr : static_cast<Base*>(items.data()); }
+			void swap_remove(std::size_t i) override
+			{
+				if (i + 1 != items.size())
+				{
+					items[i] = std::move(items.back());
+				}
+				items.pop_back();
+			}
+			void clear() override { items.clear(); }
+		};
+
+		std::vector<std::unique_ptr<segment_base>> segments;
+		segment_base* last_used = nullptr; // consecutive inserts are usually of one type
+		std::size_t count = 0;
+
+		segment_base* find(const std::type_info* type) const
+		{
+			if (last_used && last_used->type == type)
+			{
+				return last_used;
+			}
+			for (auto& s : segments)
+			{
+				if (s->type == type)
+				{
+					return s.get();
+				}
+			}
+			// type_info objects are not always unique (e.g. across shared
+			// libraries); operator== may compare names, so it is the slow path.
+			for (auto& s : segments)
+			{
+				if (*s->type == *type)
+				{
+					return s.get();
+				}
+			}
+			return nullptr;
+		}
+
+		template <typename T>
+		segment<T>& segment_for()
+		{
+			segment_base* s = find(&typeid(T));
+			if (!s)
+			{
+				segments.emplace_back(new segment<T>);
+				s = segments.back().get();
+			}
+			last_used = s;
+			return static_cast<segment<T>&>(*s);
+		}
+
+		template <typename T, typename... Ts, typename Fn>
+		bool visit_as(segment_base& s, Fn& fn)
+		{
+			if (s.type == &typeid(T) || *s.type == typeid(T))
+			{
+				for (T& x : static_cast<segment<T>&>(s).items)
+				{
+					fn(x);
+				}
+				return true;
+			}
+			if constexpr (sizeof...(Ts) > 0)
+			{
+				return visit_as<Ts...>(s, fn);
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+	public:
+		collection() = default;
+		collection(collection&& o) noexcept
+			: segments(std::move(o.segments)), last_used(std::exchange(o.last_used, nullptr)), count(std::exchange(o.count, 0))
+		{
+		}
+		collection& operator=(collection&& o) noexcept
+		{
+			segments = std::move(o.segments);
+			last_used = std::exchange(o.last_used, nullptr);
+			count = std::exchange(o.count, 0);
+			return *this;
+		}
+
+		template <typename T, typename... Args>
+		T& emplace(Args&&... args)
+		{
+			static_assert(std::is_base_of<Base, T>::value, "poly::collection elements must derive from Base");
+			auto& s = segment_for<T>();
+			s.items.emplace_back(std::forward<Args>(args)...);
+			++count;
+			return s.items.back();
+		}
+
+		template <typename T>
+		std::decay_t<T>& insert(T&& value)
+		{
+			return emplace<std::decay_t<T>>(std::forward<T>(value));
+		}
+
+		// obj must be an element of this collection.
+		void erase(Base& obj)
+		{
+			segment_base& s = *find(&typeid(obj));
+			const std::size_t i = std::size_t(reinterpret_cast<char*>(&obj) - reinterpret_cast<char*>(s.first())) / s.stride;
+			s.swap_remove(i);
+			--count;
+		}
+
+		// Erases every element for which pred(Base&) is true; returns how many.
+		template <typename Pred>
+		std::size_t erase_if(Pred pred)
+		{
+			std::size_t erased = 0;
+			for (auto& s : segments)
+			{
+				for (std::size_t i = 0; i < s->size();)
+				{
+					if (pred(*s->at(s->first(), i)))
+					{
+						s->swap_remove(i);
+						++erased;
+					}
+					else
+					{
+						++i;
+					}
+				}
+			}
+			count -= erased;
+			return erased;
+		}
+
+		// Calls fn on every element, one type after another. Elements whose type
+		// is in Ts are passed as that type, the rest as Base&.
+		template <typename... Ts, typename Fn>
+		void for_each(Fn&& fn)
+		{
+			for (auto& s : segments)
+			{
+				if constexpr (sizeof...(Ts) > 0)
+				{
+					if (visit_as<Ts...>(*s, fn))
+					{
+						continue;
+					}
+				}
+				Base* base = s->first();
+				for (std::size_t i = 0, n = s->size(); i < n; ++i)
+				{
+					fn(*s->at(base, i));
+				}
+			}
+		}
+
+		std::size_t size() const { return count; }
+		bool empty() const { return count == 0; }
+		std::size_t segment_count() const { return segments.size(); }
+
+		template <typename T>
+		std::size_t size() const
+		{
+			const segment_base* s = find(&typeid(T));
+			return s ? s->size() : 0;
+		}
+
+		template <typename T>
+		void reserve(std::size_t n)
+		{
+			segment_for<T>().items.reserve(n);
+		}
+
+		void clear()
+		{
+			for (auto& s : segments)
+			{
+				s->clear();
+			}
+			count = 0;
+		}
+	};
+}
@@ -0,0 +1,457 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(_WIN32)
+#pragma comment(lib, "Synchronization.lib")
+extern "C" __declspec(dllimport) int __stdcall WaitOnAddress(volatile void* address, void* compare, std::size_t size, unsigned long ms);
+extern "C" __declspec(dllimport) void __stdcall WakeByAddressSingle(void* address);
+extern "C" __declspec(dllimport) void __stdcall WakeByAddressAll(void* address);
+#elif defined(__linux__)
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+Concurrent queues
+spsc_queue: a bounded ring for exactly one producer and one consumer thread. Each side owns one index and only reads the other's, so every operation finishes in a bounded number of steps (wait-free). Each side also keeps a cached copy of the other index and only reloads it when the ring looks full or empty. That keeps the shared cache line from bouncing on every call.
+
+mpmc_queue: a bounded queue for any number of producers and consumers (Dmitry Vyukov's design). Every cell carries a sequence number that says whose turn it is, so a producer and a consumer only contend on the same cell, and claiming a position is a single compare-and-swap.
+
+blocking_queue<Q>: turns try_push/try_pop into push/pop that sleep on a futex (WaitOnAddress on Windows) instead of spinning, and adds close() for shutdown. The atomic load/store, compare-and-swap and acquire/release orderings used here are the ones the "Memory model" notes in C++17Template.h describe.
+
+The indices sit on separate cache lines so that producers and consumers do not falsely share them. push_batch/pop_batch move up to n elements for the cost of one index update.
+*/
+namespace queues
+{
+	constexpr std::size_t cache_line = 64;
+
+	namespace detail
+	{
+		inline std::size_t round_up(std::size_t n)
+		{
+			std::size_t p = 2;
+			while (p < n) p *= 2;
+			return p;
+		}
+
+		static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t), "futex word must be a plain 32-bit integer");
+
+		// Sleeps while word == expected; may return spuriously.
+		inline void wait(std::atomic<std::uint32_t>& word, std::uint32_t expected)
+		{
+#if defined(_WIN32)
+			WaitOnAddress(&word, &expected, sizeof(expected), 0xffffffffu);
+#elif defined(__linux__)
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+			if (word.load() == expected) std::this_thread::yield();
+#endif
+		}
+
+		inline void wake_one(std::atomic<std::uint32_t>& word)
+		{
+#if defined(_WIN32)
+			WakeByAddressSingle(&word);
+#elif defined(__linux__)
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+			(void)word;
+#endif
+		}
+
+		inline void wake_all(std::atomic<std::uint32_t>& word)
+		{
+#if defined(_WIN32)
+			WakeByAddressAll(&word);
+#elif defined(__linux__)
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+			(void)word;
+#endif
+		}
+	}
+
+	template <typename T>
+	class spsc_queue
+	{
+	public:
+		// Capacity is rounded up to a power of two.
+		explicit spsc_queue(std::size_t capacity)
+			: mask(detail::round_up(capacity) - 1), buffer(std::make_unique<T[]>(mask + 1)) {}
+
+		spsc_queue(const spsc_queue&) = delete;
+		spsc_queue& operator=(const spsc_queue&) = delete;
+
+		std::size_t capacity() const { return mask + 1; }
+
+		// Producer only. The value is only moved from on success.
+		template <typename U>
+		bool try_push(U&& value)
+		{
+			const std::size_t t = tail.value.load(std::memory_order_relaxed);
+			if (t - head_cache.value == capacity())
+			{
+				head_cache.value = head.value.load(std::memory_order_acquire);
+				if (t - head_cache.value == capacity())
+				{
+					return false;
+				}
+			}
+			buffer[t & mask] = std::forward<U>(value);
+			tail.value.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Producer only. Returns how many of the n elements were pushed.
+		std::size_t push_batch(const T* values, std::size_t n)
+		{
+			const std::size_t t = tail.value.load(std::memory_order_relaxed);
+			std::size_t room = capacity() - (t - head_cache.value);
+			if (room < n)
+			{
+				head_cache.value = head.value.load(std::memory_order_acquire);
+				room = capacity() - (t - head_cache.value);
+			}
+			const std::size_t k = n < room ? n : room;
+			for (std::size_t i = 0; i < k; ++i)
+			{
+				buffer[(t + i) & mask] = values[i];
+			}
+			tail.value.store(t + k, std::memory_order_release);
+			return k;
+		}
+
+		// Consumer only.
+		bool try_pop(T& out)
+		{
+			const std::size_t h = head.value.load(std::memory_order_relaxed);
+			if (h == tail_cache.value)
+			{
+				tail_cache.value = tail.value.load(std::memory_order_acquire);
+				if (h == tail_cache.value)
+				{
+					return false;
+				}
+			}
+			out = std::move(buffer[h & mask]);
+			head.value.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Returns how many elements were written to out.
+		std::size_t pop_batch(T* out, std::size_t max)
+		{
+			const std::size_t h = head.value.load(std::memory_order_relaxed);
+			std::size_t ready = tail_cache.value - h;
+			if (ready < max)
+			{
+				tail_cache.value = tail.value.load(std::memory_order_acquire);
+				ready = tail_cache.value - h;
+			}
+			const std::size_t k = max < ready ? max : ready;
+			for (std::size_t i = 0; i < k; ++i)
+			{
+				out[i] = std::move(buffer[(h + i) & mask]);
+			}
+			head.value.store(h + k, std::memory_order_release);
+			return k;
+		}
+
+		// Approximate when called concurrently.
+		std::size_t size() const
+		{
+			return tail.value.load(std::memory_order_acquire) - head.value.load(std::memory_order_acquire);
+		}
+
+	private:
+		template <typename V>
+		struct alignas(cache_line) padded
+		{
+			V value{};
+		};
+
+		const std::size_t mask;
+		std::unique_ptr<T[]> buffer;
+		padded<std::atomic<std::size_t>> head;  // written by the consumer
+		padded<std::size_t> tail_cache;         // consumer's copy of tail
+		padded<std::atomic<std::size_t>> tail;  // written by the producer
+		padded<std::size_t> head_cache;         // producer's copy of head
+	};
+
+	template <typename T>
+	class mpmc_queue
+	{
+	public:
+		// Capacity is rounded up to a power of two.
+		explicit mpmc_queue(std::size_t capacity)
+			: mask(detail::round_up(capacity) - 1), cells(std::make_unique<cell[]>(mask + 1))
+		{
+			for (std::size_t i = 0; i <= mask; ++i)
+			{
+				cells[i].seq.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		mpmc_queue(const mpmc_queue&) = delete;
+		mpmc_queue& operator=(const mpmc_queue&) = delete;
+
+		std::size_t capacity() const { return mask + 1; }
+
+		// The value is only moved from on success.
+		template <typename U>
+		bool try_push(U&& value)
+		{
+			std::size_t pos;
+			if (claim(enqueue_pos, 0, 1, pos) == 0)
+			{
+				return false;
+			}
+			cell& c = cells[pos & mask];
+			c.data = std::forward<U>(value);
+			c.seq.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool try_pop(T& out) { return pop_batch(&out, 1) == 1; }
+
+		// Claims up to n consecutive free cells with one compare-and-swap.
+		std::size_t push_batch(const T* values, std::size_t n)
+		{
+			std::size_t pos;
+			const std::size_t k = claim(enqueue_pos, 0, n, pos);
+			for (std::size_t i = 0; i < k; ++i)
+			{
+				cell& c = cells[(pos + i) & mask];
+				c.data = values[i];
+				c.seq.store(pos + i + 1, std::memory_order_release);
+			}
+			return k;
+		}
+
+		std::size_t pop_batch(T* out, std::size_t max)
+		{
+			std::size_t pos;
+			const std::size_t k = claim(dequeue_pos, 1, max, pos);
+			for (std::size_t i = 0; i < k; ++i)
+			{
+				cell& c = cells[(pos + i) & mask];
+				out[i] = std::move(c.data);
+				c.seq.store(pos + i + mask + 1, std::memory_order_release);
+			}
+			return k;
+		}
+
+	private:
+		struct cell
+		{
+			std::atomic<std::size_t> seq;
+			T data;
+		};
+
+		// Claims up to n positions starting at `index`. The cell for position p is
+		// ready when its sequence is p + lag: lag 0 means free for a producer,
+		// lag 1 means holding a value for a consumer. Returns 0 if the queue is
+		// full (producers) or empty (consumers).
+		std::size_t claim(std::atomic<std::size_t>& index, std::size_t lag, std::size_t n, std::size_t& pos)
+		{
+			pos = index.load(std::memory_order_relaxed);
+			for (;;)
+			{
+				std::size_t k = 0;
+				while (k < n && cells[(pos + k) & mask].seq.load(std::memory_order_acquire) == pos + k + lag)
+				{
+					++k;
+				}
+				if (k == 0)
+				{
+					const std::size_t seq = cells[pos & mask].seq.load(std::memory_order_acquire);
+					if (static_cast<std::ptrdiff_t>(seq - (pos + lag)) < 0)
+					{
+						return 0;
+					}
+					pos = index.load(std::memory_order_relaxed); // another thread got there first
+					continue;
+				}
+				// Cells seen ready stay ready until someone advances `index` past them,
+				// so a successful CAS owns all k of them.
+				if (index.compare_exchange_weak(pos, pos + k, std::memory_order_relaxed))
+				{
+					return k;
+				}
+			}
+		}
+
+		const std::size_t mask;
+		std::unique_ptr<cell[]> cells;
+		alignas(cache_line) std::atomic<std::size_t> enqueue_pos{ 0 };
+		alignas(cache_line) std::atomic<std::size_t> dequeue_pos{ 0 };
+	};
+
+	// Blocking push/pop over spsc_queue or mpmc_queue. Waiters sleep on an
+	// event counter that is bumped after every successful push (pop); the
+	// wake-up system call is skipped when nobody is waiting.
+	template <typename Queue>
+	class blocking_queue
+	{
+	public:
+		explicit blocking_queue(std::size_t capacity) : q(capacity) {}
+
+		// Returns false if the queue is closed, leaving the value with the caller.
+		// A push that races with close() may still go in; pop() drains it.
+		template <typename T>
+		bool push(T&& value)
+		{
+			for (;;)
+			{
+				// seq before closed: if close() bumped seq after this load, the
+				// sleep below returns at once and the next pass sees closed.
+				const std::uint32_t seq = space.seq.load(std::memory_order_seq_cst);
+				if (closed.load(std::memory_order_acquire))
+				{
+					return false;
+				}
+				if (q.try_push(std::forward<T>(value)))
+				{
+					notify(items);
+					return true;
+				}
+				sleep(space, seq);
+			}
+		}
+
+		// Returns false once the queue is closed and drained.
+		template <typename T>
+		bool pop(T& out)
+		{
+			for (;;)
+			{
+				const std::uint32_t seq = items.seq.load(std::memory_order_seq_cst);
+				if (q.try_pop(out))
+				{
+					notify(space);
+					return true;
+				}
+				if (closed.load(std::memory_order_acquire))
+				{
+					if (!q.try_pop(out))
+					{
+						return false;
+					}
+					notify(space);
+					return true;
+				}
+				sleep(items, seq);
+			}
+		}
+
+		template <typename T>
+		bool try_push(T&& value)
+		{
+			if (!q.try_push(std::forward<T>(value)))
+			{
+				return false;
+			}
+			notify(items);
+			return true;
+		}
+
+		template <typename T>
+		bool try_pop(T& out)
+		{
+			if (!q.try_pop(out))
+			{
+				return false;
+			}
+			notify(space);
+			return true;
+		}
+
+		template <typename T>
+		std::size_t push_batch(const T* values, std::size_t n)
+		{
+			const std::size_t k = q.push_batch(values, n);
+			if (k) notify(items, true);
+			return k;
+		}
+
+		template <typename T>
+		std::size_t pop_batch(T* out, std::size_t max)
+		{
+			const std::size_t k = q.pop_batch(out, max);
+			if (k) notify(space, true);
+			return k;
+		}
+
+		// Wakes every waiter; pop() drains what is left and then returns false.
+		void close()
+		{
+			closed.store(true, std::memory_order_release);
+			items.seq.fetch_add(1, std::memory_order_seq_cst);
+			space.seq.fetch_add(1, std::memory_order_seq_cst);
+			items.waiters.store(0, std::memory_order_seq_cst);
+			space.waiters.store(0, std::memory_order_seq_cst);
+			detail::wake_all(items.seq);
+			detail::wake_all(space.seq);
+		}
+
+		Queue& queue() { return q; }
+
+	private:
+		struct alignas(cache_line) event
+		{
+			std::atomic<std::uint32_t> seq{ 0 };
+			std::atomic<std::uint32_t> waiters{ 0 };
+		};
+
+		// The caller read `seq` before its failed attempt. Any push/pop since then
+		// has bumped seq (and sees waiters != 0 or makes the futex return at once),
+		// so the wake-up cannot be lost.
+		void sleep(event& e, std::uint32_t seq)
+		{
+			e.waiters.fetch_add(1, std::memory_order_seq_cst);
+			detail::wait(e.seq, seq);
+		}
+
+		// `waiters` is only decremented here, once per wake-up sent, so a burst of
+		// pushes makes one system call per sleeper rather than one per push. A
+		// sleeper whose wait returned early leaves the count one too high, which
+		// costs at most one extra wake-up later.
+		void notify(event& e, bool all = false)
+		{
+			e.seq.fetch_add(1, std::memory_order_seq_cst);
+			std::uint32_t n = e.waiters.load(std::memory_order_seq_cst);
+			if (n == 0)
+			{
+				return;
+			}
+			if (all)
+			{
+				if (e.waiters.exchange(0, std::memory_order_seq_cst) != 0)
+				{
+					detail::wake_all(e.seq);
+				}
+				return;
+			}
+			while (n != 0 && !e.waiters.compare_exchange_weak(n, n - 1, std::memory_order_seq_cst))
+			{
+			}
+			if (n != 0)
+			{
+				detail::wake_one(e.seq);
+			}
+		}
+
+		Queue q;
+		event items;
+		event space;
+		std::atomic<bool> closed{ false };
+	};
+}
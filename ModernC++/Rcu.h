@@ -0,0 +1,241 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+Read-copy-update
+MyObj::getValueCopy() captures [*this] and getValueRef() captures [this]: the first lambda keeps seeing the value it was created with, the second sees every later change. rcu::cell<T> makes that snapshot behaviour safe across threads for read-mostly data such as routing tables. Readers call read() and get an immutable snapshot without taking a lock or writing to a shared cache line. Writers copy the current value, modify the copy, and publish it with one atomic pointer swap.
+
+An old version cannot be deleted while a reader may still hold it. Each reader announces the global epoch it entered in, in a per-thread slot, and a retired version is freed once every active reader has entered a later epoch (epoch-based reclamation). Keep snapshots short-lived: a snapshot that is held open delays the freeing of old versions, though it never blocks writers.
+*/
+namespace rcu
+{
+	namespace detail
+	{
+		struct alignas(64) reader_record
+		{
+			std::atomic<std::uint64_t> epoch{ 0 }; // 0 = not reading
+			std::atomic<bool> in_use{ false };
+			reader_record* next = nullptr;
+			unsigned depth = 0; // nested read guards; only touched by the owner
+		};
+
+		// Process-wide epoch and the list of per-thread reader records. Records
+		// are recycled when their thread exits and are never freed.
+		class domain
+		{
+		public:
+			static domain& instance()
+			{
+				static domain d;
+				return d;
+			}
+
+			reader_record* acquire()
+			{
+				for (reader_record* r = head.load(std::memory_order_acquire); r; r = r->next)
+				{
+					bool expected = false;
+					if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(expected, true))
+					{
+						return r;
+					}
+				}
+				auto* r = new reader_record;
+				r->in_use.store(true, std::memory_order_relaxed);
+				r->next = head.load(std::memory_order_relaxed);
+				while (!head.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed))
+				{
+				}
+				return r;
+			}
+
+			void release(reader_record* r) { r->in_use.store(false, std::memory_order_release); }
+
+			// Oldest epoch any reader is still in, or UINT64_MAX if nobody is reading.
+			std::uint64_t min_active() const
+			{
+				std::uint64_t m = UINT64_MAX;
+				for (reader_record* r = head.load(std::memory_order_acquire); r; r = r->next)
+				{
+					const std::uint64_t e = r->epoch.load(std::memory_order_seq_cst);
+					if (e != 0 && e < m)
+					{
+						m = e;
+					}
+				}
+				return m;
+			}
+
+			std::atomic<std::uint64_t> epoch{ 1 };
+
+		private:
+			std::atomic<reader_record*> head{ nullptr };
+		};
+
+		struct thread_record
+		{
+			reader_record* record = domain::instance().acquire();
+			~thread_record() { domain::instance().release(record); }
+		};
+
+		inline reader_record& this_thread_record()
+		{
+			thread_local thread_record r;
+			return *r.record;
+		}
+	}
+
+	// Marks the calling thread as reading for its lifetime. Nests.
+	class read_guard
+	{
+		detail::reader_record& r;
+
+	public:
+		read_guard() : r(detail::this_thread_record())
+		{
+			if (r.depth++ == 0)
+			{
+				// Acquire: a reader that sees epoch e also sees the pointer published before e.
+				r.epoch.store(detail::domain::instance().epoch.load(std::memory_order_acquire), std::memory_order_seq_cst);
+			}
+		}
+		~read_guard()
+		{
+			if (--r.depth == 0)
+			{
+				r.epoch.store(0, std::memory_order_release);
+			}
+		}
+		read_guard(const read_guard&) = delete;
+		read_guard& operator=(const read_guard&) = delete;
+	};
+
+	// An immutable view of one version; valid while it lives, on the thread that took it.
+	template <typename T>
+	class snapshot
+	{
+		read_guard guard;
+		const T* value;
+
+	public:
+		explicit snapshot(const std::atomic<T*>& current) : value(current.load(std::memory_order_seq_cst)) {}
+		snapshot(const snapshot&) = delete;
+		snapshot& operator=(const snapshot&) = delete;
+
+		const T& operator*() const { return *value; }
+		const T* operator->() const { return value; }
+		const T* get() const { return value; }
+	};
+
+	template <typename T>
+	class cell
+	{
+	public:
+		template <typename... Args>
+		explicit cell(Args&&... args) : current(new T(std::forward<Args>(args)...)) {}
+
+		cell(const cell&) = delete;
+		cell& operator=(const cell&) = delete;
+
+		~cell()
+		{
+			delete current.load();
+			for (auto& r : retired)
+			{
+				delete r.second;
+			}
+		}
+
+		snapshot<T> read() const { return snapshot<T>(current); }
+
+		// Calls fn(const T&) on the current version without copying it out.
+		template <typename Fn>
+		decltype(auto) with(Fn&& fn) const
+		{
+			snapshot<T> s(current);
+			return std::forward<Fn>(fn)(*s);
+		}
+
+		// Copies the current version, lets fn modify the copy, then publishes it.
+		// Writers are serialized; readers are never blocked.
+		template <typename Fn>
+		void update(Fn&& fn)
+		{
+			std::lock_guard<std::mutex> lk(writer);
+			auto next = std::make_unique<T>(*current.load(std::memory_order_relaxed));
+			std::forward<Fn>(fn)(*next);
+			publish(next.release());
+		}
+
+		void store(T value)
+		{
+			std::lock_guard<std::mutex> lk(writer);
+			publish(new T(std::move(value)));
+		}
+
+		// Frees every retired version no reader can still see. Called by each
+		// writer; call it directly to free memory sooner after a burst of updates.
+		std::size_t reclaim()
+		{
+			std::lock_guard<std::mutex> lk(writer);
+			return reclaim_locked();
+		}
+
+		// Blocks until all retired versions are freed. Must not be called while
+		// this thread holds a snapshot.
+		void synchronize()
+		{
+			while (reclaim(), pending() != 0)
+			{
+				std::this_thread::yield();
+			}
+		}
+
+		std::size_t pending() const
+		{
+			std::lock_guard<std::mutex> lk(writer);
+			return retired.size();
+		}
+
+	private:
+		void publish(T* next)
+		{
+			T* old = current.exchange(next, std::memory_order_seq_cst);
+			// Readers that may hold `old` entered at an epoch <= e.
+			const std::uint64_t e = detail::domain::instance().epoch.fetch_add(1, std::memory_order_seq_cst);
+			retired.emplace_back(e, old);
+			reclaim_locked();
+		}
+
+		std::size_t reclaim_locked()
+		{
+			const std::uint64_t oldest = detail::domain::instance().min_active();
+			std::size_t freed = 0;
+			for (std::size_t i = 0; i < retired.size();)
+			{
+				if (retired[i].first < oldest)
+				{
+					delete retired[i].second;
+					retired[i] = retired.back();
+					retired.pop_back();
+					++freed;
+				}
+				else
+				{
+					++i;
+				}
+			}
+			return freed;
+		}
+
+		std::atomic<T*> current;
+		mutable std::mutex writer;
+		std::vector<std::pair<std::uint64_t, T*>> retired;
+	};
+}
@@ -0,0 +1,173 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/*
+slot_map
+A registry that owns objects in one contiguous array and hands out 64-bit handles (32-bit slot index + 32-bit generation) instead of pointers. Erasing an object bumps its slot's generation, so a stale handle is detected in O(1) by comparing generations. Live objects stay packed (erase moves the last object into the hole), which keeps "update every object" passes a linear scan through memory instead of a walk over separately allocated std::unique_ptr targets.
+
+Handles stay valid across insertions and erasures of other objects; references and iterators do not.
+*/
+class slot_handle
+{
+	std::uint64_t bits = 0;
+
+public:
+	constexpr slot_handle() = default;
+	constexpr slot_handle(std::uint32_t index, std::uint32_t generation)
+		: bits((static_cast<std::uint64_t>(generation) << 32) | index) {}
+
+	constexpr std::uint32_t index() const { return static_cast<std::uint32_t>(bits); }
+	constexpr std::uint32_t generation() const { return static_cast<std::uint32_t>(bits >> 32); }
+	constexpr std::uint64_t value() const { return bits; }
+
+	// Generations start at 1, so a default-constructed handle never resolves.
+	constexpr explicit operator bool() const { return generation() != 0; }
+
+	friend constexpr bool operator==(slot_handle a, slot_handle b) { return a.bits == b.bits; }
+	friend constexpr bool operator!=(slot_handle a, slot_handle b) { return a.bits != b.bits; }
+};
+
+template <typename T>
+class slot_map
+{
+	struct slot
+	{
+		std::uint32_t dense_or_next_free; // dense index while live, next free slot otherwise
+		std::uint32_t generation;
+	};
+
+	static constexpr std::uint32_t no_free = 0xffffffffu;
+
+	std::vector<T> values;               // live objects, packed
+	std::vector<std::uint32_t> owners;   // slot index of values[i]
+	std::vector<slot> slots;
+	std::uint32_t free_head = no_free;
+
+public:
+	using iterator = typename std::vector<T>::iterator;
+	using const_iterator = typename std::vector<T>::const_iterator;
+
+	void reserve(std::size_t n)
+	{
+		values.reserve(n);
+		owners.reserve(n);
+		slots.reserve(n);
+	}
+
+	// If anything throws, the map is left as it was.
+	template <typename... Args>
+	slot_handle emplace(Args&&... args)
+	{
+		// Everything that can throw comes first, and the value last.
+		const bool fresh = free_head == no_free;
+		if (fresh)
+		{
+			slots.push_back({ 0, 1 });
+		}
+		try
+		{
+			owners.push_back(0);
+			values.emplace_back(std::forward<Args>(args)...);
+		}
+		catch (...)
+		{
+			owners.resize(values.size());
+			if (fresh)
+			{
+				slots.pop_back();
+			}
+			throw;
+		}
+		std::uint32_t index;
+		if (fresh)
+		{
+			index = static_cast<std::uint32_t>(slots.size() - 1);
+		}
+		else
+		{
+			index = free_head;
+			free_head = slots[index].dense_or_next_free;
+		}
+		slots[index].dense_or_next_free = static_cast<std::uint32_t>(values.size() - 1);
+		owners.back() = index;
+		return slot_handle(index, slots[index].generation);
+	}
+
+	slot_handle insert(T value) { return emplace(std::move(value)); }
+
+	bool contains(slot_handle h) const
+	{
+		return h.index() < slots.size() && slots[h.index()].generation == h.generation();
+	}
+
+	// Returns nullptr for stale or null handles.
+	T* get(slot_handle h)
+	{
+		return contains(h) ? &values[slots[h.index()].dense_or_next_free] : nullptr;
+	}
+
+	const T* get(slot_handle h) const
+	{
+		return contains(h) ? &values[slots[h.index()].dense_or_next_free] : nullptr;
+	}
+
+	bool erase(slot_handle h)
+	{
+		if (!contains(h))
+		{
+			return false;
+		}
+		slot& s = slots[h.index()];
+		const std::uint32_t dense = s.dense_or_next_free;
+		const std::uint32_t last = static_cast<std::uint32_t>(values.size() - 1);
+		if (dense != last)
+		{
+			values[dense] = std::move(values[last]);
+			owners[dense] = owners[last];
+			slots[owners[dense]].dense_or_next_free = dense;
+		}
+		values.pop_back();
+		owners.pop_back();
+
+		// Skip generation 0 on wrap-around so that null handles stay invalid.
+		s.generation = s.generation + 1 == 0 ? 1 : s.generation + 1;
+		s.dense_or_next_free = free_head;
+		free_head = h.index();
+		return true;
+	}
+
+	void clear()
+	{
+		for (std::uint32_t i = 0; i < owners.size(); ++i)
+		{
+			slot& s = slots[owners[i]];
+			s.generation = s.generation + 1 == 0 ? 1 : s.generation + 1;
+			s.dense_or_next_free = free_head;
+			free_head = owners[i];
+		}
+		values.clear();
+		owners.clear();
+	}
+
+	std::size_t size() const { return values.size(); }
+	bool empty() const { return values.empty(); }
+
+	// Linear iteration over the live objects, in storage order.
+	iterator begin() { return values.begin(); }
+	iterator end() { return values.end(); }
+	const_iterator begin() const { return values.begin(); }
+	const_iterator end() const { return values.end(); }
+
+	// Calls fn(handle, object) for every live object.
+	template <typename Fn>
+	void for_each(Fn&& fn)
+	{
+		for (std::size_t i = 0; i < values.size(); ++i)
+		{
+			fn(slot_handle(owners[i], slots[owners[i]].generation), values[i]);
+		}
+	}
+};
@@ -0,0 +1,290 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/*
+small_vector
+A vector-like sequence container that keeps up to N elements in inline storage and only spills to the heap when it grows past that. Short sequences, such as the ones built from a braced list, never touch the allocator.
+
+Moving a small_vector follows the same rules as the A4 move members: a spilled buffer is stolen from the source, while inline elements are moved one by one, leaving the source empty.
+*/
+template <typename T, std::size_t N = 8>
+class small_vector
+{
+	static_assert(N > 0, "small_vector needs at least one inline slot");
+
+public:
+	using value_type = T;
+	using size_type = std::size_t;
+	using difference_type = std::ptrdiff_t;
+	using reference = T&;
+	using const_reference = const T&;
+	using pointer = T*;
+	using const_pointer = const T*;
+	using iterator = T*;
+	using const_iterator = const T*;
+
+	static constexpr size_type inline_capacity = N;
+
+	small_vector() noexcept : ptr(inline_data()), count(0), cap(N) {}
+
+	small_vector(std::initializer_list<T> list) : small_vector()
+	{
+		assign(list.begin(), list.end());
+	}
+
+	explicit small_vector(size_type n, const T& value = T()) : small_vector()
+	{
+		reserve(n);
+		std::uninitialized_fill_n(ptr, n, value);
+		count = n;
+	}
+
+	template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+	small_vector(InputIt first, InputIt last) : small_vector()
+	{
+		assign(first, last);
+	}
+
+	// Interoperability with the `Vec<T>` alias (std::vector<T>).
+	explicit small_vector(const std::vector<T>& v) : small_vector(v.begin(), v.end()) {}
+
+	explicit small_vector(std::vector<T>&& v) : small_vector()
+	{
+		reserve(v.size());
+		std::uninitialized_move(v.begin(), v.end(), ptr);
+		count = v.size();
+		v.clear();
+	}
+
+	small_vector(const small_vector& o) : small_vector()
+	{
+		assign(o.begin(), o.end());
+	}
+
+	small_vector(small_vector&& o) noexcept(std::is_nothrow_move_constructible<T>::value) : small_vector()
+	{
+		steal(std::move(o));
+	}
+
+	~small_vector()
+	{
+		clear();
+		release();
+	}
+
+	small_vector& operator=(const small_vector& o)
+	{
+		if (this != &o)
+		{
+			assign(o.begin(), o.end());
+		}
+		return *this;
+	}
+
+	small_vector& operator=(small_vector&& o) noexcept(std::is_nothrow_move_constructible<T>::value)
+	{
+		if (this != &o)
+		{
+			clear();
+			release();
+			steal(std::move(o));
+		}
+		return *this;
+	}
+
+	small_vector& operator=(std::initializer_list<T> list)
+	{
+		assign(list.begin(), list.end());
+		return *this;
+	}
+
+	template <typename InputIt>
+	void assign(InputIt first, InputIt last)
+	{
+		clear();
+		if constexpr (std::is_base_of<std::forward_iterator_tag,
+			typename std::iterator_traits<InputIt>::iterator_category>::value)
+		{
+			const auto n = static_cast<size_type>(std::distance(first, last));
+			reserve(n);
+			std::uninitialized_copy(first, last, ptr);
+			count = n;
+		}
+		else
+		{
+			for (; first != last; ++first)
+			{
+				emplace_back(*first);
+			}
+		}
+	}
+
+	// Element access
+	reference operator[](size_type i) noexcept { return ptr[i]; }
+	const_reference operator[](size_type i) const noexcept { return ptr[i]; }
+
+	reference at(size_type i)
+	{
+		if (i >= count) throw std::out_of_range("small_vector::at");
+		return ptr[i];
+	}
+
+	const_reference at(size_type i) const
+	{
+		if (i >= count) throw std::out_of_range("small_vector::at");
+		return ptr[i];
+	}
+
+	reference front() noexcept { return ptr[0]; }
+	const_reference front() const noexcept { return ptr[0]; }
+	reference back() noexcept { return ptr[count - 1]; }
+	const_reference back() const noexcept { return ptr[count - 1]; }
+	pointer data() noexcept { return ptr; }
+	const_pointer data() const noexcept { return ptr; }
+
+	// Iterators
+	iterator begin() noexcept { return ptr; }
+	const_iterator begin() const noexcept { return ptr; }
+	const_iterator cbegin() const noexcept { return ptr; }
+	iterator end() noexcept { return ptr + count; }
+	const_iterator end() const noexcept { return ptr + count; }
+	const_iterator cend() const noexcept { return ptr + count; }
+
+	// Capacity
+	bool empty() const noexcept { return count == 0; }
+	size_type size() const noexcept { return count; }
+	size_type capacity() const noexcept { return cap; }
+	bool is_inline() const noexcept { return ptr == inline_data(); }
+
+	void reserve(size_type n)
+	{
+		if (n > cap)
+		{
+			grow(n);
+		}
+	}
+
+	// Modifiers
+	void clear() noexcept
+	{
+		std::destroy(ptr, ptr + count);
+		count = 0;
+	}
+
+	void push_back(const T& value) { emplace_back(value); }
+	void push_back(T&& value) { emplace_back(std::move(value)); }
+
+	template <typename... Args>
+	reference emplace_back(Args&&... args)
+	{
+		if (count == cap)
+		{
+			// Construct first: `args` may alias an element that grow() relocates.
+			T tmp(std::forward<Args>(args)...);
+			grow(cap * 2);
+			::new (static_cast<void*>(ptr + count)) T(std::move(tmp));
+		}
+		else
+		{
+			::new (static_cast<void*>(ptr + count)) T(std::forward<Args>(args)...);
+		}
+		return ptr[count++];
+	}
+
+	void pop_back() noexcept
+	{
+		ptr[--count].~T();
+	}
+
+	void resize(size_type n)
+	{
+		if (n < count)
+		{
+			std::destroy(ptr + n, ptr + count);
+		}
+		else
+		{
+			reserve(n);
+			std::uninitialized_value_construct(ptr + count, ptr + n);
+		}
+		count = n;
+	}
+
+	// Copies the elements into a `Vec<T>`.
+	std::vector<T> to_vec() const { return std::vector<T>(begin(), end()); }
+
+	friend bool operator==(const small_vector& a, const small_vector& b)
+	{
+		return std::equal(a.begin(), a.end(), b.begin(), b.end());
+	}
+
+	friend bool operator!=(const small_vector& a, const small_vector& b) { return !(a == b); }
+
+private:
+	T* inline_data() noexcept { return reinterpret_cast<T*>(&storage); }
+	const T* inline_data() const noexcept { return reinterpret_cast<const T*>(&storage); }
+
+	void grow(size_type n)
+	{
+		T* fresh = std::allocator<T>().allocate(n);
+		try
+		{
+			std::uninitialized_move(ptr, ptr + count, fresh);
+		}
+		catch (...)
+		{
+			// uninitialized_move has already destroyed what it built.
+			std::allocator<T>().deallocate(fresh, n);
+			throw;
+		}
+		std::destroy(ptr, ptr + count);
+		release();
+		ptr = fresh;
+		cap = n;
+	}
+
+	// Returns a spilled buffer to the heap; inline storage stays put.
+	void release() noexcept
+	{
+		if (!is_inline())
+		{
+			std::allocator<T>().deallocate(ptr, cap);
+			ptr = inline_data();
+			cap = N;
+		}
+	}
+
+	// Precondition: *this is empty and inline.
+	void steal(small_vector&& o)
+	{
+		if (o.is_inline())
+		{
+			std::uninitialized_move(o.begin(), o.end(), ptr);
+			count = o.count;
+			o.clear();
+		}
+		else
+		{
+			ptr = o.ptr;
+			count = o.count;
+			cap = o.cap;
+			o.ptr = o.inline_data();
+			o.count = 0;
+			o.cap = N;
+		}
+	}
+
+	T* ptr;
+	size_type count;
+	size_type cap;
+	typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type storage;
+};
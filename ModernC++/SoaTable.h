@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "BatchApply.h"
+
+/*
+Columnar table
+A std::vector<std::tuple<int, std::string, std::string>> of player profiles stores each row's fields side by side. Summing the numbers then reads 72 bytes per row to use 4 of them, and the tuple's padding is stored a million times. soa::table<Ts...> keeps one std::vector per field, so a scan of one column reads only that column. The loop is a plain walk over one array that the compiler can vectorize, and nothing is padded between rows.
+
+Rows still read like tuples. table[i] returns a std::tuple of references into the columns, so auto [number, name, team] = table[i] binds to the stored fields, std::tie(n, s, t) = table[i] copies them out, and table[i] = std::make_tuple(...) overwrites them. Iterating the table yields the same proxies. Because a proxy holds references, it is invalidated by push_back, erase_if and the sorts, just as a std::vector iterator would be.
+
+Whole-column operations take the column index as a template argument: reduce<I>, count_if<I>, select<I> (the row numbers that match, built without a branch per row), erase_if<I> and sort_by<I>. A sort orders row numbers by one column and then moves every column into that order, so the other fields are moved once instead of at every swap. column_view<I>() and columns<Is...>() give batch::column spans for batch::apply.
+*/
+namespace soa
+{
+	template <typename... Ts>
+	class table
+	{
+		static_assert(!(std::is_same<Ts, bool>::value || ...), "std::vector<bool> has no bool& to bind to; store flags as char");
+
+		std::tuple<std::vector<Ts>...> cols;
+
+		template <std::size_t... I>
+		std::tuple<Ts&...> row(std::size_t i, std::index_sequence<I...>) { return std::tuple<Ts&...>(std::get<I>(cols)[i]...); }
+		template <std::size_t... I>
+		std::tuple<const Ts&...> row(std::size_t i, std::index_sequence<I...>) const { return std::tuple<const Ts&...>(std::get<I>(cols)[i]...); }
+
+		template <typename Fn, std::size_t... I>
+		void each_column(Fn&& fn, std::index_sequence<I...>) { (fn(std::get<I>(cols)), ...); }
+
+		template <typename Row, std::size_t... I>
+		void push(Row&& r, std::index_sequence<I...>) { (std::get<I>(cols).push_back(std::get<I>(std::forward<Row>(r))), ...); }
+
+	public:
+		using value_type = std::tuple<Ts...>;
+		using reference = std::tuple<Ts&...>;
+		using const_reference = std::tuple<const Ts&...>;
+
+		template <std::size_t I>
+		using field_type = std::tuple_element_t<I, value_type>;
+
+		template <typename Ref, typename Table>
+		class basic_iterator
+		{
+			Table* t;
+			std::size_t i;
+
+		public:
+			using iterator_category = std::input_iterator_tag;
+			using value_type = table::value_type;
+			using reference = Ref;
+			using difference_type = std::ptrdiff_t;
+			using pointer = void;
+
+			basic_iterator(Table* t, std::size_t i) : t(t), i(i) {}
+			Ref operator*() const { return (*t)[i]; }
+			basic_iterator& operator++() { ++i; return *this; }
+			basic_iterator operator++(int) { basic_iterator old = *this; ++i; return old; }
+			bool operator==(const basic_iterator& o) const { return i == o.i; }
+			bool operator!=(const basic_iterator& o) const { return i != o.i; }
+		};
+		using iterator = basic_iterator<reference, table>;
+		using const_iterator = basic_iterator<const_reference, const table>;
+
+		table() = default;
+
+		std::size_t size() const { return std::get<0>(cols).size(); }
+		bool empty() const { return size() == 0; }
+
+		void reserve(std::size_t n) { each_column([n](auto& c) { c.reserve(n); }, std::index_sequence_for<Ts...>()); }
+		void clear() { each_column([](auto& c) { c.clear(); }, std::index_sequence_for<Ts...>()); }
+
+		// One value per column, or one tuple holding them.
+		template <typename... Us, typename = std::enable_if_t<sizeof...(Us) == sizeof...(Ts)>>
+		void push_back(Us&&... fields) { push(std::forward_as_tuple(std::forward<Us>(fields)...), std::index_sequence_for<Ts...>()); }
+		template <typename... Us>
+		void push_back(const std::tuple<Us...>& r) { push(r, std::index_sequence_for<Ts...>()); }
+		template <typename... Us>
+		void push_back(std::tuple<Us...>&& r) { push(std::move(r), std::index_sequence_for<Ts...>()); }
+
+		reference operator[](std::size_t i) { return row(i, std::index_sequence_for<Ts...>()); }
+		const_reference operator[](std::size_t i) const { return row(i, std::index_sequence_for<Ts...>()); }
+
+		iterator begin() { return iterator(this, 0); }
+		iterator end() { return iterator(this, size()); }
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, size()); }
+
+		template <std::size_t I>
+		std::vector<field_type<I>>& column() { return std::get<I>(cols); }
+		template <std::size_t I>
+		const std::vector<field_type<I>>& column() const { return std::get<I>(cols); }
+
+		template <std::size_t I>
+		batch::column<field_type<I>> column_view() { return batch::column<field_type<I>>(std::get<I>(cols)); }
+		template <std::size_t... Is>
+		auto columns() { return std::make_tuple(column_view<Is>()...); }
+
+		// Heap bytes held by the columns (capacity, not size).
+		std::size_t memory_bytes() const
+		{
+			std::size_t bytes = 0;
+			std::apply([&](const auto&... c) { ((bytes += c.capacity() * sizeof(c[0])), ...); }, cols);
+			return bytes;
+		}
+
+		// op(op(op(init, c[0]), c[1]), ...) over column I.
+		template <std::size_t I, typename T, typename Op = std::plus<>>
+		T reduce(T init, Op op = Op()) const
+		{
+			for (const auto& x : std::get<I>(cols))
+			{
+				init = op(init, x);
+			}
+			return init;
+		}
+
+		template <std::size_t I, typename Pred>
+		std::size_t count_if(Pred pred) const
+		{
+			std::size_t n = 0;
+			for (const auto& x : std::get<I>(cols))
+			{
+				n += pred(x) ? 1 : 0;
+			}
+			return n;
+		}
+
+		// Row numbers, ascending, of the rows whose column I satisfies pred.
+		template <std::size_t I, typename Pred>
+		std::vector<std::size_t> select(Pred pred) const
+		{
+			const auto& c = std::get<I>(cols);
+			std::vector<std::size_t> rows(c.size());
+			std::size_t k = 0;
+			for (std::size_t i = 0; i < c.size(); ++i)
+			{
+				// Always store, then keep the slot only if it matched: no branch to mispredict.
+				rows[k] = i;
+				k += pred(c[i]) ? 1 : 0;
+			}
+			rows.resize(k);
+			return rows;
+		}
+
+		// A new table holding copies of the given rows, in that order.
+		table gather(const std::vector<std::size_t>& rows) const
+		{
+			table out;
+			out.reserve(rows.size());
+			out.each_column_from(*this, [&](auto& dst, const auto& src) {
+				for (std::size_t r : rows)
+				{
+					dst.push_back(src[r]);
+				}
+			});
+			return out;
+		}
+
+		// Keeps only the given rows, in that order. Each row may appear once.
+		void permute(const std::vector<std::size_t>& rows)
+		{
+			each_column([&](auto& c) {
+				std::remove_reference_t<decltype(c)> next;
+				next.reserve(rows.size());
+				for (std::size_t r : rows)
+				{
+					assert(r < c.size());
+					next.push_back(std::move(c[r]));
+				}
+				c = std::move(next);
+			}, std::index_sequence_for<Ts...>());
+		}
+
+		template <std::size_t I, typename Pred>
+		std::size_t erase_if(Pred pred)
+		{
+			const std::size_t before = size();
+			permute(select<I>([&](const auto& x) { return !pred(x); }));
+			return before - size();
+		}
+
+		// Stable sort of the rows by column I.
+		template <std::size_t I, typename Compare = std::less<>>
+		void sort_by(Compare comp = Compare())
+		{
+			const auto& key = std::get<I>(cols);
+			std::vector<std::size_t> order(size());
+			std::iota(order.begin(), order.end(), std::size_t(0));
+			std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return comp(key[a], key[b]); });
+			permute(order);
+		}
+
+	private:
+		template <typename Fn>
+		void each_column_from(const table& src, Fn&& fn)
+		{
+			each_column_from(src, fn, std::index_sequence_for<Ts...>());
+		}
+		template <typename Fn, std::size_t... I>
+		void each_column_from(const table& src, Fn& fn, std::index_sequence<I...>)
+		{
+			(fn(std::get<I>(cols), std::get<I>(src.cols)), ...);
+		}
+	};
+}
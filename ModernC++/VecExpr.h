@@ -0,0 +1,235 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ArrayKernels.h"
+
+/*
+Expression templates
+With plain operator overloads, a + b + c + d over Vec<double> allocates and writes a temporary vector for each +, so the data goes through memory three extra times. Here, + - * / on vexpr operands only build a small tree of index-able nodes, and the tree is evaluated when it is assigned to a vexpr::array (or reduced with vexpr::total). Evaluation is one loop, out[i] = a[i] + b[i] + c[i] + d[i], which the compiler can vectorize.
+
+vexpr::ref(v) lets an existing Vec<double> take part without a copy. vexpr::add and vexpr::sum mirror the scalar add() and the variadic sum() fold from C++17Template.h. parallel_eval() splits the loop across threads. Nodes keep pointers to their arrays, so an expression must not outlive the arrays it reads.
+*/
+namespace vexpr
+{
+	template <typename E>
+	struct expr
+	{
+		const E& self() const { return static_cast<const E&>(*this); }
+	};
+
+	// Non-owning view of contiguous elements; the leaf of every tree.
+	template <typename T>
+	struct leaf : expr<leaf<T>>
+	{
+		using value_type = T;
+		const T* data;
+		std::size_t n;
+
+		leaf(const T* p, std::size_t n) : data(p), n(n) {}
+		std::size_t size() const { return n; }
+		T operator[](std::size_t i) const { return data[i]; }
+	};
+
+	// A scalar broadcast to every index, e.g. the 2.0 in 2.0 * a.
+	template <typename T>
+	struct scalar : expr<scalar<T>>
+	{
+		using value_type = T;
+		T value;
+
+		explicit scalar(T v) : value(v) {}
+		std::size_t size() const { return 0; } // matches any size
+		T operator[](std::size_t) const { return value; }
+	};
+
+	template <typename Op, typename L, typename R>
+	struct binary : expr<binary<Op, L, R>>
+	{
+		using value_type = std::decay_t<decltype(Op()(std::declval<typename L::value_type>(), std::declval<typename R::value_type>()))>;
+		L l;
+		R r;
+
+		binary(L l, R r) : l(std::move(l)), r(std::move(r))
+		{
+			assert(this->l.size() == 0 || this->r.size() == 0 || this->l.size() == this->r.size());
+		}
+		std::size_t size() const { return l.size() != 0 ? l.size() : r.size(); }
+		value_type operator[](std::size_t i) const { return Op()(l[i], r[i]); }
+	};
+
+	template <typename T>
+	leaf<T> ref(const std::vector<T>& v)
+	{
+		return leaf<T>(v.data(), v.size());
+	}
+
+	namespace detail
+	{
+		template <typename T, typename E>
+		void fill(T* out, const E& x, std::size_t first, std::size_t last)
+		{
+			for (std::size_t i = first; i < last; ++i)
+			{
+				out[i] = x[i];
+			}
+		}
+	}
+
+	// Owning numeric array; assigning an expression evaluates it in one pass.
+	template <typename T>
+	class array
+	{
+		std::vector<T> values;
+
+	public:
+		using value_type = T;
+
+		array() = default;
+		explicit array(std::size_t n, T v = T()) : values(n, v) {}
+		array(std::vector<T> v) : values(std::move(v)) {}
+
+		template <typename E>
+		array(const expr<E>& e) { *this = e; }
+
+		template <typename E>
+		array& operator=(const expr<E>& e)
+		{
+			const E& x = e.self();
+			if (x.size() == values.size())
+			{
+				// Element i only reads index i, so a = a + b is safe in place.
+				detail::fill(values.data(), x, 0, x.size());
+			}
+			else
+			{
+				// Resizing in place could move storage that x still reads.
+				std::vector<T> fresh(x.size());
+				detail::fill(fresh.data(), x, 0, x.size());
+				values.swap(fresh);
+			}
+			return *this;
+		}
+
+		std::size_t size() const { return values.size(); }
+		T& operator[](std::size_t i) { return values[i]; }
+		const T& operator[](std::size_t i) const { return values[i]; }
+		T* data() { return values.data(); }
+		const T* data() const { return values.data(); }
+		const std::vector<T>& vec() const { return values; }
+		std::vector<T> release() { return std::move(values); }
+
+		leaf<T> view() const { return leaf<T>(values.data(), values.size()); }
+	};
+
+	namespace detail
+	{
+		template <typename T>
+		struct is_array : std::false_type {};
+		template <typename T>
+		struct is_array<array<T>> : std::true_type {};
+
+		template <typename T>
+		constexpr bool is_operand = std::is_base_of<expr<T>, T>::value || is_array<T>::value;
+
+		template <typename T>
+		auto as_expr(const T& x)
+		{
+			if constexpr (is_array<T>::value)
+			{
+				return x.view();
+			}
+			else if constexpr (std::is_arithmetic<T>::value)
+			{
+				return scalar<T>(x);
+			}
+			else
+			{
+				return x;
+			}
+		}
+
+		template <typename L, typename R>
+		constexpr bool enable_op = (is_operand<L> && (is_operand<R> || std::is_arithmetic<R>::value))
+			|| (std::is_arithmetic<L>::value && is_operand<R>);
+
+		template <typename Op, typename L, typename R>
+		auto make(const L& l, const R& r)
+		{
+			using LE = decltype(as_expr(l));
+			using RE = decltype(as_expr(r));
+			return binary<Op, LE, RE>(as_expr(l), as_expr(r));
+		}
+	}
+
+	template <typename L, typename R, typename = std::enable_if_t<detail::enable_op<L, R>>>
+	auto operator+(const L& l, const R& r) { return detail::make<std::plus<>>(l, r); }
+
+	template <typename L, typename R, typename = std::enable_if_t<detail::enable_op<L, R>>>
+	auto operator-(const L& l, const R& r) { return detail::make<std::minus<>>(l, r); }
+
+	template <typename L, typename R, typename = std::enable_if_t<detail::enable_op<L, R>>>
+	auto operator*(const L& l, const R& r) { return detail::make<std::multiplies<>>(l, r); }
+
+	template <typename L, typename R, typename = std::enable_if_t<detail::enable_op<L, R>>>
+	auto operator/(const L& l, const R& r) { return detail::make<std::divides<>>(l, r); }
+
+	// Element-wise counterparts of add(x, y) and the sum(args...) fold.
+	template <typename L, typename R>
+	auto add(const L& l, const R& r)
+	{
+		return l + r;
+	}
+
+	template <typename... Args>
+	auto sum(const Args&... args)
+	{
+		return (... + args);
+	}
+
+	// Evaluates `e` into `out` on all hardware threads.
+	template <typename T, typename E>
+	void parallel_eval(array<T>& out, const expr<E>& e, std::size_t min_chunk = 1 << 18)
+	{
+		const E& x = e.self();
+		assert(out.size() == x.size());
+		T* dst = out.data();
+		array_kernels::parallel_chunks(x.size(), [&](std::size_t first, std::size_t last) {
+			detail::fill(dst, x, first, last);
+		}, min_chunk);
+	}
+
+	// Sum of all elements of an expression, without materializing it. Four
+	// independent accumulators let the loop vectorize without -ffast-math.
+	template <typename E>
+	auto total(const expr<E>& e)
+	{
+		const E& x = e.self();
+		using V = typename E::value_type;
+		V acc[4] = {};
+		const std::size_t n = x.size();
+		std::size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			acc[0] += x[i];
+			acc[1] += x[i + 1];
+			acc[2] += x[i + 2];
+			acc[3] += x[i + 3];
+		}
+		for (; i < n; ++i)
+		{
+			acc[0] += x[i];
+		}
+		return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+	}
+
+	template <typename T>
+	T total(const array<T>& a)
+	{
+		return total(a.view());
+	}
+}